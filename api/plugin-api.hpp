@@ -187,6 +187,7 @@ struct OTR_API_EXPORT ITracker
     // optional destructor
     virtual ~ITracker();
     // start tracking, and grab a frame to display webcam video in, optionally
+    // frame is null when running headless, skip all preview work then
     virtual module_status start_tracker(QFrame* frame) = 0;
     // return XYZ yaw pitch roll data. don't block here, use a separate thread for computation.
     virtual void data(double *data) = 0;
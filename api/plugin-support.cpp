@@ -0,0 +1,397 @@
+#include "plugin-support.hpp"
+#include "compat/timer.hpp"
+#include "options/globals.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace plugin_support_impl {
+
+// bump when the layout below changes
+static constexpr quint32 cache_magic = 0x6f746d63, cache_version = 2;
+
+struct cache_entry
+{
+    qint64 mtime = -1, size = -1;
+    quint32 type = dylib::Invalid;
+    QString name;
+    QIcon icon;
+};
+
+using cache_t = QHash<QString, cache_entry>;
+
+static QString cache_pathname()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (dir.isEmpty())
+        return {};
+    dir += QStringLiteral("/" OPENTRACK_ORG);
+    if (!QDir(dir).mkpath("."))
+        return {};
+    return dir + QStringLiteral("/modules.cache");
+}
+
+// module names come from tr(), they're only good for the language they
+// were read in. same choice of translation as gui/init.cpp.
+static QString cache_language()
+{
+    using namespace options::globals;
+
+    const bool no_i18n = !std::getenv("OTR_FORCE_LANG") && with_global_settings_object([](QSettings& s) {
+        return s.value("disable-translation", false).toBool();
+    });
+
+    return no_i18n ? QStringLiteral("C") : QLocale().name();
+}
+
+static bool cache_disabled()
+{
+    static const bool ret = std::getenv("OPENTRACK_NO_MODULE_CACHE") != nullptr;
+    return ret;
+}
+
+static cache_t read_cache(const QString& pathname)
+{
+    cache_t ret;
+
+    QFile f(pathname);
+    if (pathname.isEmpty() || cache_disabled() || !f.open(QFile::ReadOnly))
+        return ret;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0, version = 0, count = 0;
+    QString language;
+    s >> magic >> version >> language >> count;
+
+    if (magic != cache_magic || version != cache_version || language != cache_language())
+        return ret;
+
+    for (unsigned k = 0; k < count && s.status() == QDataStream::Ok; k++)
+    {
+        QString filename;
+        cache_entry e;
+        s >> filename >> e.mtime >> e.size >> e.type >> e.name >> e.icon;
+        ret[filename] = std::move(e);
+    }
+
+    if (s.status() != QDataStream::Ok)
+    {
+        qDebug() << "module cache" << pathname << "corrupted, ignoring";
+        ret.clear();
+    }
+
+    return ret;
+}
+
+static void write_cache(const QString& pathname, const cache_t& cache)
+{
+    if (pathname.isEmpty())
+        return;
+
+    QSaveFile f(pathname);
+    if (!f.open(QFile::WriteOnly))
+        return;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_6);
+
+    s << cache_magic << cache_version << cache_language() << (quint32)cache.size();
+
+    for (auto it = cache.cbegin(); it != cache.cend(); ++it)
+    {
+        const cache_entry& e = it.value();
+        s << it.key() << e.mtime << e.size << e.type << e.name << e.icon;
+    }
+
+    if (s.status() != QDataStream::Ok || !f.commit())
+        qDebug() << "can't write module cache" << pathname;
+}
+
+// runs fun(k) for 0 <= k < n on all cores
+template<typename F>
+static void parallel_for(unsigned n, F&& fun)
+{
+    const unsigned nthreads = std::min(n, std::max(1u, std::thread::hardware_concurrency()));
+
+    if (nthreads <= 1)
+    {
+        for (unsigned k = 0; k < n; k++)
+            fun(k);
+        return;
+    }
+
+    std::atomic<unsigned> next { 0 };
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+
+    for (unsigned i = 0; i < nthreads; i++)
+        threads.emplace_back([&] {
+            for (unsigned k; (k = next.fetch_add(1, std::memory_order_relaxed)) < n; )
+                fun(k);
+        });
+
+    for (std::thread& t : threads)
+        t.join();
+}
+
+} // ns plugin_support_impl
+
+using namespace plugin_support_impl;
+
+dylib::dylib(const QString& filename_, Type t) :
+    full_filename(filename_),
+    module_name(trim_filename(filename_))
+{
+    // otherwise dlopen opens the calling executable
+    if (filename_.isEmpty() || module_name.isEmpty())
+        return;
+
+    handle.setFileName(filename_);
+    handle.setLoadHints(QLibrary::DeepBindHint | QLibrary::PreventUnloadHint | QLibrary::ResolveAllSymbolsHint);
+
+    type = t;
+}
+
+bool dylib::load()
+{
+    QMutexLocker l(&mtx);
+    return load_nolock();
+}
+
+bool dylib::load_nolock()
+{
+    if (loadedp)
+        return type != Invalid;
+
+    if (type == Invalid)
+        return false;
+
+    loadedp = true;
+
+#ifdef __clang__
+#   pragma clang diagnostic push
+#   pragma clang diagnostic ignored "-Wcomma"
+#endif
+
+    if (check(!handle.load()))
+        return false;
+
+    if (check((Dialog = (module_ctor_t) handle.resolve("GetDialog"), !Dialog)))
+        return false;
+
+    if (check((Constructor = (module_ctor_t) handle.resolve("GetConstructor"), !Constructor)))
+        return false;
+
+    if (check((Meta = (module_metadata_t) handle.resolve("GetMetadata"), !Meta)))
+        return false;
+
+#ifdef __clang__
+#   pragma clang diagnostic pop
+#endif
+
+    return true;
+}
+
+bool dylib::read_metadata()
+{
+    // Metadata is a QObject, only call this on the main thread
+    if (!load())
+        return false;
+
+    std::unique_ptr<Metadata_> m{Meta()};
+
+    icon = m->icon();
+    name = m->name();
+
+    return true;
+}
+
+QList<std::shared_ptr<dylib>> dylib::enum_libraries(const QString& library_path)
+{
+    Timer t;
+
+    QDir module_directory(library_path);
+    QList<std::shared_ptr<dylib>> ret;
+
+    using str = QLatin1String;
+
+    const struct filter_ {
+        Type type;
+        QLatin1String glob;
+    } filters[] = {
+        { Filter, str(OPENTRACK_LIBRARY_PREFIX "opentrack-filter-*." OPENTRACK_LIBRARY_EXTENSION), },
+        { Tracker, str(OPENTRACK_LIBRARY_PREFIX "opentrack-tracker-*." OPENTRACK_LIBRARY_EXTENSION), },
+        { Protocol, str(OPENTRACK_LIBRARY_PREFIX "opentrack-proto-*." OPENTRACK_LIBRARY_EXTENSION), },
+        { Extension, str(OPENTRACK_LIBRARY_PREFIX "opentrack-ext-*." OPENTRACK_LIBRARY_EXTENSION), },
+    };
+
+    const QString cache_path = cache_pathname();
+    // a cache for another language is read as empty and rewritten
+    cache_t cache = read_cache(cache_path);
+
+    struct module_ { std::shared_ptr<dylib> lib; qint64 mtime, size; bool cached; };
+    std::vector<module_> modules;
+    std::vector<dylib*> misses;
+
+    for (const filter_& filter : filters)
+    {
+        for (const QString& filename : module_directory.entryList({ filter.glob }, QDir::Files, QDir::Name))
+        {
+            const QString pathname = QStringLiteral("%1/%2").arg(library_path).arg(filename);
+            const QFileInfo info(pathname);
+            auto lib = std::make_shared<dylib>(pathname, filter.type);
+
+            if (lib->type == Invalid)
+                continue;
+
+            module_ m { lib, info.lastModified().toMSecsSinceEpoch(), info.size(), false };
+
+            if (auto it = cache.constFind(pathname); it != cache.cend())
+            {
+                const cache_entry& e = *it;
+                if (e.mtime == m.mtime && e.size == m.size && e.type == filter.type)
+                {
+                    lib->name = e.name;
+                    lib->icon = e.icon;
+                    m.cached = true;
+                }
+            }
+
+            if (!m.cached)
+                misses.push_back(lib.get());
+
+            modules.push_back(std::move(m));
+        }
+    }
+
+    // linking is what's slow, the metadata is read on this thread afterwards.
+    // loading on other threads runs the modules' static initializers there.
+    // those are only QStrings, rcc's resource registration and third-party
+    // libraries' own tables, none of them tied to a thread. QLibrary::load()
+    // serializes on its own mutex. anything touching QObjects or widgets
+    // has to stay in function-local statics or constructors.
+    parallel_for((unsigned)misses.size(), [&](unsigned k) { (void)misses[k]->load(); });
+
+    bool dirty = false;
+
+    for (module_& m : modules)
+    {
+        const std::shared_ptr<dylib>& lib = m.lib;
+
+        if (!m.cached)
+        {
+            dirty = true;
+
+            if (!lib->read_metadata())
+            {
+                cache.remove(lib->full_filename);
+                continue;
+            }
+
+            cache[lib->full_filename] = { m.mtime, m.size, lib->type, lib->name, lib->icon };
+        }
+
+        if (std::any_of(ret.cbegin(),
+                        ret.cend(),
+                        [&lib](const std::shared_ptr<dylib>& a) {
+                            return a->type == lib->type && a->name == lib->name;
+                        }))
+        {
+            qDebug() << "duplicate lib" << lib->full_filename << "ident" << lib->name;
+            continue;
+        }
+
+        ret.push_back(lib);
+    }
+
+    // forget modules that were removed from this directory
+    for (auto it = cache.begin(); it != cache.end(); )
+    {
+        if (it.key().startsWith(library_path + '/') && !QFileInfo::exists(it.key()))
+        {
+            it = cache.erase(it);
+            dirty = true;
+        }
+        else
+            ++it;
+    }
+
+    if (dirty)
+        write_cache(cache_path, cache);
+
+    qDebug().nospace() << "modules: " << ret.size() << " found, "
+                       << modules.size() - misses.size() << " cached, "
+                       << misses.size() << " probed in "
+                       << (int)t.elapsed_ms() << " ms";
+
+    return ret;
+}
+
+QString dylib::trim_filename(const QString& in_)
+{
+    QStringRef in(&in_);
+
+    const int idx = in.lastIndexOf("/");
+
+    if (idx != -1)
+    {
+        in = in.mid(idx + 1);
+
+        if (in.startsWith(OPENTRACK_LIBRARY_PREFIX) &&
+            in.endsWith("." OPENTRACK_LIBRARY_EXTENSION))
+        {
+            constexpr unsigned pfx_len = sizeof(OPENTRACK_LIBRARY_PREFIX) - 1;
+            constexpr unsigned rst_len = sizeof("." OPENTRACK_LIBRARY_EXTENSION) - 1;
+
+            in = in.mid(pfx_len);
+            in = in.left(in.size() - rst_len);
+
+            const char* const names[] =
+            {
+                OPENTRACK_LIBRARY_PREFIX "opentrack-tracker-",
+                OPENTRACK_LIBRARY_PREFIX "opentrack-proto-",
+                OPENTRACK_LIBRARY_PREFIX "opentrack-filter-",
+                OPENTRACK_LIBRARY_PREFIX "opentrack-ext-",
+            };
+
+            for (auto name : names)
+            {
+                if (in.startsWith(name))
+                    return in.mid(std::strlen(name)).toString();
+            }
+        }
+    }
+    return {""};
+}
+
+bool dylib::check(bool fail)
+{
+    if (fail)
+    {
+        qDebug() << "library" << module_name << "failed:" << handle.errorString();
+
+        if (handle.isLoaded())
+            (void) handle.unload();
+
+        Constructor = nullptr;
+        Dialog = nullptr;
+        Meta = nullptr;
+
+        type = Invalid;
+    }
+
+    return fail;
+}
@@ -9,25 +9,25 @@
 
 #include "plugin-api.hpp"
 #include "compat/library-path.hpp"
+#include "export.hpp"
 
 #include <memory>
 #include <algorithm>
-#include <cstring>
 
 #include <QDebug>
 #include <QString>
 #include <QLibrary>
 #include <QList>
 #include <QDir>
-#include <QList>
 #include <QIcon>
+#include <QMutex>
 
 extern "C" {
     using module_ctor_t = void* (*)(void);
     using module_metadata_t = Metadata_* (*)(void);
 }
 
-struct dylib final
+struct OTR_API_EXPORT dylib final
 {
     enum Type : unsigned
     {
@@ -38,90 +38,20 @@ struct dylib final
         Invalid = (unsigned)-1,
     };
 
-    dylib(const QString& filename_, Type t) :
-        full_filename(filename_),
-        module_name(trim_filename(filename_))
-    {
-        // otherwise dlopen opens the calling executable
-        if (filename_.isEmpty() || module_name.isEmpty())
-            return;
-
-        handle.setFileName(filename_);
-        handle.setLoadHints(QLibrary::DeepBindHint | QLibrary::PreventUnloadHint | QLibrary::ResolveAllSymbolsHint);
-
-#ifdef __clang__
-#   pragma clang diagnostic push
-#   pragma clang diagnostic ignored "-Wcomma"
-#endif
-
-        if (check(!handle.load()))
-            return;
-
-        if (check((Dialog = (module_ctor_t) handle.resolve("GetDialog"), !Dialog)))
-            return;
-
-        if (check((Constructor = (module_ctor_t) handle.resolve("GetConstructor"), !Constructor)))
-            return;
-
-        if (check((Meta = (module_metadata_t) handle.resolve("GetMetadata"), !Meta)))
-            return;
-
-        std::unique_ptr<Metadata_> m{Meta()};
-
-        icon = m->icon();
-        name = m->name();
-
-        type = t;
-#ifdef __clang__
-#   pragma clang diagnostic pop
-#endif
-    }
+    // doesn't load the library, see load()
+    dylib(const QString& filename_, Type t);
 
     // QLibrary refcounts the .dll's so don't forcefully unload
     ~dylib() = default;
 
-    static QList<std::shared_ptr<dylib>> enum_libraries(const QString& library_path)
-    {
-        QDir module_directory(library_path);
-        QList<std::shared_ptr<dylib>> ret;
+    // loads the library and resolves its entry points. libraries are only
+    // loaded once they're used since linking OpenCV modules is slow.
+    // returns false and sets type to Invalid on failure.
+    bool load();
 
-        using str = QLatin1String;
-
-        const struct filter_ {
-            Type type;
-            QLatin1String glob;
-        } filters[] = {
-            { Filter, str(OPENTRACK_LIBRARY_PREFIX "opentrack-filter-*." OPENTRACK_LIBRARY_EXTENSION), },
-            { Tracker, str(OPENTRACK_LIBRARY_PREFIX "opentrack-tracker-*." OPENTRACK_LIBRARY_EXTENSION), },
-            { Protocol, str(OPENTRACK_LIBRARY_PREFIX "opentrack-proto-*." OPENTRACK_LIBRARY_EXTENSION), },
-            { Extension, str(OPENTRACK_LIBRARY_PREFIX "opentrack-ext-*." OPENTRACK_LIBRARY_EXTENSION), },
-        };
-
-        for (const filter_& filter : filters)
-        {
-            for (const QString& filename : module_directory.entryList({ filter.glob }, QDir::Files, QDir::Name))
-            {
-                std::shared_ptr<dylib> lib = std::make_shared<dylib>(QStringLiteral("%1/%2").arg(library_path).arg(filename), filter.type);
-
-                if (lib->type == Invalid)
-                    continue;
-
-                if (std::any_of(ret.cbegin(),
-                                ret.cend(),
-                                [&lib](const std::shared_ptr<dylib>& a) {
-                                    return a->type == lib->type && a->name == lib->name;
-                                }))
-                {
-                    qDebug() << "duplicate lib" << filename << "ident" << lib->name;
-                    continue;
-                }
-
-                ret.push_back(lib);
-            }
-        }
-
-        return ret;
-    }
+    // name and icon come from the metadata cache where possible. cache misses
+    // get loaded in parallel. set OPENTRACK_NO_MODULE_CACHE to ignore the cache.
+    static QList<std::shared_ptr<dylib>> enum_libraries(const QString& library_path);
 
     Type type{Invalid};
     QString full_filename;
@@ -134,63 +64,15 @@ struct dylib final
     module_ctor_t Constructor{nullptr};
     module_metadata_t Meta{nullptr};
 private:
+    QMutex mtx;
     QLibrary handle;
+    bool loadedp = false;
 
-    static QString trim_filename(const QString& in_)
-    {
-        QStringRef in(&in_);
-
-        const int idx = in.lastIndexOf("/");
-
-        if (idx != -1)
-        {
-            in = in.mid(idx + 1);
-
-            if (in.startsWith(OPENTRACK_LIBRARY_PREFIX) &&
-                in.endsWith("." OPENTRACK_LIBRARY_EXTENSION))
-            {
-                constexpr unsigned pfx_len = sizeof(OPENTRACK_LIBRARY_PREFIX) - 1;
-                constexpr unsigned rst_len = sizeof("." OPENTRACK_LIBRARY_EXTENSION) - 1;
-
-                in = in.mid(pfx_len);
-                in = in.left(in.size() - rst_len);
-
-                const char* const names[] =
-                {
-                    OPENTRACK_LIBRARY_PREFIX "opentrack-tracker-",
-                    OPENTRACK_LIBRARY_PREFIX "opentrack-proto-",
-                    OPENTRACK_LIBRARY_PREFIX "opentrack-filter-",
-                    OPENTRACK_LIBRARY_PREFIX "opentrack-ext-",
-                };
-
-                for (auto name : names)
-                {
-                    if (in.startsWith(name))
-                        return in.mid(std::strlen(name)).toString();
-                }
-            }
-        }
-        return {""};
-    }
+    bool load_nolock();
+    bool read_metadata();
 
-    bool check(bool fail)
-    {
-        if (fail)
-        {
-            qDebug() << "library" << module_name << "failed:" << handle.errorString();
-
-            if (handle.isLoaded())
-                (void) handle.unload();
-
-            Constructor = nullptr;
-            Dialog = nullptr;
-            Meta = nullptr;
-
-            type = Invalid;
-        }
-
-        return fail;
-    }
+    static QString trim_filename(const QString& in_);
+    bool check(bool fail);
 };
 
 struct Modules final
@@ -238,7 +120,7 @@ template<typename t>
 std::shared_ptr<t> make_dylib_instance(const std::shared_ptr<dylib>& lib)
 {
     std::shared_ptr<t> ret;
-    if (lib != nullptr && lib->Constructor)
+    if (lib != nullptr && lib->load())
         ret = std::shared_ptr<t>(reinterpret_cast<t*>(reinterpret_cast<module_ctor_t>(lib->Constructor)()));
     return ret;
 }
@@ -0,0 +1,175 @@
+/* Copyright (c) 2019 Stanislaw Halik
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "rt-thread.hpp"
+
+#include <cstring>
+#include <cerrno>
+
+#include <QMutex>
+#include <QStringList>
+#include <QDebug>
+
+#if defined _WIN32
+#   include <windows.h>
+#elif defined __linux__
+#   include <pthread.h>
+#   include <sched.h>
+#   include <sys/mman.h>
+#   include <sys/resource.h>
+#endif
+
+namespace rt_thread {
+
+static QMutex lock;
+static config configs[role_count];
+
+void set_config(role r, const config& c)
+{
+    QMutexLocker l(&lock);
+    if (r < role_count)
+        configs[r] = c;
+}
+
+config get_config(role r)
+{
+    QMutexLocker l(&lock);
+    return r < role_count ? configs[r] : config{};
+}
+
+static QString errno_string(int err)
+{
+    return QString::fromLocal8Bit(std::strerror(err));
+}
+
+#if defined __linux__
+
+static void prefault_stack()
+{
+    // fault in the stack we're likely to use so locked pages are already there
+    constexpr unsigned size = 64 * 1024;
+    volatile char buf[size];
+    for (unsigned k = 0; k < size; k += 4096)
+        buf[k] = 0;
+}
+
+static QString set_realtime(int priority)
+{
+    const int min = sched_get_priority_min(SCHED_FIFO), max = sched_get_priority_max(SCHED_FIFO);
+
+    priority = priority < min ? min : priority > max ? max : priority;
+
+    // without CAP_SYS_NICE the rlimit is the ceiling
+    struct rlimit rl {};
+    if (getrlimit(RLIMIT_RTPRIO, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY &&
+        rl.rlim_cur > 0 && (rlim_t)priority > rl.rlim_cur)
+        priority = (int)rl.rlim_cur;
+
+    sched_param param {};
+    param.sched_priority = priority;
+
+    if (int err = pthread_setschedparam(pthread_self(), SCHED_FIFO | SCHED_RESET_ON_FORK, &param); err != 0)
+        return QStringLiteral("SCHED_FIFO %1 denied (%2)").arg(priority).arg(errno_string(err));
+
+    return QStringLiteral("SCHED_FIFO %1").arg(priority);
+}
+
+static QString set_affinity(int cpu)
+{
+    if (cpu >= CPU_SETSIZE)
+        return QStringLiteral("cpu %1 out of range").arg(cpu);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); err != 0)
+        return QStringLiteral("cpu %1 denied (%2)").arg(cpu).arg(errno_string(err));
+
+    return QStringLiteral("cpu %1").arg(cpu);
+}
+
+static QString lock_memory()
+{
+    static QString ret;
+    static QMutex mtx;
+    QMutexLocker l(&mtx);
+
+    if (ret.isEmpty())
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+            ret = QStringLiteral("mlockall");
+        else
+            ret = QStringLiteral("mlockall denied (%1)").arg(errno_string(errno));
+    }
+
+    return ret;
+}
+
+#elif defined _WIN32
+
+static void prefault_stack() {}
+
+static QString set_realtime(int)
+{
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+        return QStringLiteral("TIME_CRITICAL denied (%1)").arg(GetLastError());
+    return QStringLiteral("TIME_CRITICAL");
+}
+
+static QString set_affinity(int cpu)
+{
+    if (cpu >= (int)sizeof(DWORD_PTR) * 8)
+        return QStringLiteral("cpu %1 out of range").arg(cpu);
+
+    if (!SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu))
+        return QStringLiteral("cpu %1 denied (%2)").arg(cpu).arg(GetLastError());
+    return QStringLiteral("cpu %1").arg(cpu);
+}
+
+static QString lock_memory()
+{
+    return QStringLiteral("memory locking unsupported");
+}
+
+#else
+
+static void prefault_stack() {}
+static QString set_realtime(int) { return QStringLiteral("realtime scheduling unsupported"); }
+static QString set_affinity(int) { return QStringLiteral("cpu affinity unsupported"); }
+static QString lock_memory() { return QStringLiteral("memory locking unsupported"); }
+
+#endif
+
+QString apply(role r, const char* thread_name)
+{
+    const config c = get_config(r);
+
+    if (!c.realtime && c.cpu < 0 && !c.lock_memory)
+        return {};
+
+    QStringList ret;
+
+    if (c.lock_memory)
+        ret << lock_memory();
+
+    if (c.realtime)
+        ret << set_realtime(c.priority);
+
+    if (c.cpu >= 0)
+        ret << set_affinity(c.cpu);
+
+    if (c.lock_memory)
+        prefault_stack();
+
+    const QString str = ret.join(QStringLiteral(", "));
+    qDebug().nospace().noquote() << "rt: " << thread_name << ": " << str;
+
+    return str;
+}
+
+} // ns rt_thread
@@ -0,0 +1,42 @@
+#pragma once
+
+/* Copyright (c) 2019 Stanislaw Halik
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "export.hpp"
+
+#include <QString>
+
+namespace rt_thread {
+
+enum role : unsigned
+{
+    pipeline,
+    capture,
+    role_count,
+};
+
+struct config final
+{
+    // SCHED_FIFO on Linux, TIME_CRITICAL on Windows
+    bool realtime = false;
+    int priority = 10;
+    // -1 means don't pin
+    int cpu = -1;
+    // mlockall(), process-wide, done once
+    bool lock_memory = false;
+};
+
+// the main program sets these before trackers and the pipeline start
+OTR_COMPAT_EXPORT void set_config(role r, const config& c);
+OTR_COMPAT_EXPORT config get_config(role r);
+
+// call first thing in the thread's run(). returns what was granted, also
+// written to the debug log, since without privileges most of it is refused.
+OTR_COMPAT_EXPORT QString apply(role r, const char* thread_name);
+
+} // ns rt_thread
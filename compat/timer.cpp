@@ -9,11 +9,33 @@
 #undef NDEBUG
 
 #include "timer.hpp"
+#include "macros.hpp"
 #include <cassert>
 #include <cmath>
 
 using time_type = Timer::time_type;
 
+static thread_local const struct timespec* replay_now = nullptr;
+
+replay_clock::replay_clock()
+{
+    assert(!replay_now && "replay clocks don't nest");
+    Timer::gettime(&now);
+    replay_now = &now;
+}
+
+replay_clock::~replay_clock()
+{
+    replay_now = nullptr;
+}
+
+void replay_clock::advance_nsecs(time_type ns)
+{
+    ns += now.tv_nsec;
+    now.tv_sec += decltype(now.tv_sec)(ns / 1000000000LL);
+    now.tv_nsec = decltype(now.tv_nsec)(ns % 1000000000LL);
+}
+
 Timer::Timer()
 {
     start();
@@ -118,6 +140,12 @@ static void otr_clock_gettime(timespec* ts)
 
 void Timer::gettime(timespec* state)
 {
+    if (unlikely(replay_now != nullptr))
+    {
+        *state = *replay_now;
+        return;
+    }
+
 #if defined(_WIN32) || defined(__MACH__)
     otr_clock_gettime(state);
 #elif defined CLOCK_MONOTONIC
@@ -38,4 +38,23 @@ private:
     static void gettime(struct timespec* state);
     time_type conv_nsecs(const struct timespec& cur) const;
     using ns = time_units::ns;
+
+    friend struct replay_clock;
+};
+
+// while alive, Timers on the thread that created it read this clock
+// instead of the system's. lets recorded sessions run faster than real
+// time through code that measures its own dt.
+struct OTR_COMPAT_EXPORT replay_clock final
+{
+    replay_clock();
+    ~replay_clock();
+
+    void advance_nsecs(Timer::time_type ns);
+
+    replay_clock(const replay_clock&) = delete;
+    replay_clock& operator=(const replay_clock&) = delete;
+
+private:
+    struct timespec now {};
 };
@@ -11,13 +11,22 @@
 
 #include "csv.h"
 #include "compat/library-path.hpp"
+#include "compat/timer.hpp"
 #include <QTextDecoder>
 #include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QString>
 #include <QDebug>
 
+#include <cstdio>
+#include <iterator>
 #include <utility>
 #include <algorithm>
+#include <vector>
 
 const QTextCodec* const CSV::m_codec = QTextCodec::codecForName("System");
 const QRegExp CSV::m_rx = QRegExp(QString("((?:(?:[^;\\n]*;?)|(?:\"[^\"]*\";?))*)?\\n?"));
@@ -88,32 +97,69 @@ bool CSV::parseLine(QStringList& ret)
     return true;
 }
 
-bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
+namespace csv_impl {
+
+struct game_entry
 {
-    for (int i = 0; i < 8; i++)
-        table[i] = 0;
+    int id = 0;
+    bool has_table = false;
+    unsigned char table[8] {};
+    QString name;
+};
 
-    if (id != 0)
-        qDebug() << "csv: lookup game id" << id;
+// bump when the layout below changes
+static constexpr quint32 cache_magic = 0x6f746763, cache_version = 1;
 
-    QString id_str(QString::number(id));
+static QString csv_pathname()
+{
+    return OPENTRACK_BASE_PATH + OPENTRACK_DOC_PATH "settings/facetracknoir supported games.csv";
+}
 
-    static const QString csv_path(OPENTRACK_BASE_PATH +
-                                  OPENTRACK_DOC_PATH "settings/facetracknoir supported games.csv");
+static QString cache_pathname()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (dir.isEmpty())
+        return {};
+    dir += QStringLiteral("/" OPENTRACK_ORG);
+    if (!QDir(dir).mkpath("."))
+        return {};
+    return dir + QStringLiteral("/games.cache");
+}
 
-    QFile file(csv_path);
+static bool parse_table(const QString& proto, const QString& id_str, unsigned char* table, int lineno)
+{
+    const QByteArray id_cstr = id_str.toLatin1();
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    if (proto == QStringLiteral("V160") || id_cstr.length() != 22)
+        return false;
+
+    unsigned tmp[8];
+    unsigned fuzz[3];
+
+    if (sscanf(id_cstr.constData(),
+               "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
+               fuzz + 2,
+               fuzz + 0,
+               tmp + 3, tmp + 2, tmp + 1, tmp + 0,
+               tmp + 7, tmp + 6, tmp + 5, tmp + 4,
+               fuzz + 1) != 11)
     {
-        qDebug() << "csv: can't open game list for freetrack protocol!";
+        qDebug() << "scanf failed" << lineno;
         return false;
     }
 
-    CSV csv(&file);
+    for (int i = 0; i < 8; i++)
+        table[i] = (unsigned char)tmp[i];
 
-    unsigned tmp[8];
-    unsigned fuzz[3];
+    return true;
+}
+
+static std::vector<game_entry> read_csv(QFile& file)
+{
+    std::vector<game_entry> ret;
+    ret.reserve(2048);
 
+    CSV csv(&file);
     QStringList gameLine;
 
     for (int lineno = 0; csv.parseLine(gameLine); lineno++)
@@ -127,45 +173,162 @@ bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
         //qDebug() << "Column 6: " << gameLine.at(6);		// International ID
         //qDebug() << "Column 7: " << gameLine.at(7);		// FaceTrackNoIR ID
 
-        if (gameLine.count() == 8)
+        if (gameLine.count() != 8)
         {
-            if (gameLine.at(6).compare(id_str, Qt::CaseInsensitive) == 0)
-            {
-                const QString& proto = gameLine[3];
-                QString& name = gameLine[1];
-
-                const QByteArray id_cstr = gameLine[7].toLatin1();
-
-                auto do_scanf = [&]() {
-                    return sscanf(id_cstr.constData(),
-                                  "%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x",
-                                  fuzz + 2,
-                                  fuzz + 0,
-                                  tmp + 3, tmp + 2, tmp + 1, tmp + 0,
-                                  tmp + 7, tmp + 6, tmp + 5, tmp + 4,
-                                  fuzz + 1);
-                };
-
-                if (proto == QStringLiteral("V160") || id_cstr.length() != 22)
-                    (void)0;
-                else if (id_cstr.length() != 22 || do_scanf() != 11)
-                    qDebug() << "scanf failed" << lineno;
-                else
-                {
-                    using uchar = unsigned char;
-                    for (int i = 0; i < 8; i++)
-                        table[i] = uchar(tmp[i]);
-                }
-                gamename = std::move(name);
-                return true;
-            }
-        }
-        else
             qDebug() << "malformed csv line" << lineno;
+            continue;
+        }
+
+        bool ok = false;
+        game_entry e;
+        e.id = gameLine[6].toInt(&ok);
+
+        if (!ok)
+            continue;
+
+        e.has_table = parse_table(gameLine[3], gameLine[7], e.table, lineno);
+        e.name = std::move(gameLine[1]);
+
+        ret.push_back(std::move(e));
+    }
+
+    // first line with a given id wins, like the old linear search
+    std::stable_sort(ret.begin(), ret.end(), [](const game_entry& a, const game_entry& b) { return a.id < b.id; });
+    ret.shrink_to_fit();
+
+    return ret;
+}
+
+static bool read_cache(const QString& pathname, qint64 mtime, qint64 size, std::vector<game_entry>& ret)
+{
+    QFile f(pathname);
+    if (pathname.isEmpty() || !f.open(QFile::ReadOnly))
+        return false;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_6);
+
+    quint32 magic = 0, version = 0, count = 0;
+    qint64 csv_mtime = -1, csv_size = -1;
+    s >> magic >> version >> csv_mtime >> csv_size >> count;
+
+    if (magic != cache_magic || version != cache_version || csv_mtime != mtime || csv_size != size)
+        return false;
+
+    ret.clear();
+    ret.reserve(count);
+
+    for (unsigned k = 0; k < count && s.status() == QDataStream::Ok; k++)
+    {
+        game_entry e;
+        qint32 id = 0;
+        bool has_table = false;
+        s >> id >> has_table >> e.name;
+        if (s.readRawData((char*)e.table, sizeof(e.table)) != sizeof(e.table))
+            break;
+        e.id = id; e.has_table = has_table;
+        ret.push_back(std::move(e));
+    }
+
+    if (s.status() != QDataStream::Ok || ret.size() != count)
+    {
+        ret.clear();
+        return false;
+    }
+
+    return true;
+}
+
+static void write_cache(const QString& pathname, qint64 mtime, qint64 size, const std::vector<game_entry>& games)
+{
+    if (pathname.isEmpty())
+        return;
+
+    QSaveFile f(pathname);
+    if (!f.open(QFile::WriteOnly))
+        return;
+
+    QDataStream s(&f);
+    s.setVersion(QDataStream::Qt_5_6);
+
+    s << cache_magic << cache_version << mtime << size << (quint32)games.size();
+
+    for (const game_entry& e : games)
+    {
+        s << (qint32)e.id << e.has_table << e.name;
+        s.writeRawData((const char*)e.table, sizeof(e.table));
+    }
+
+    if (s.status() != QDataStream::Ok || !f.commit())
+        qDebug() << "csv: can't write game list cache" << pathname;
+}
+
+static std::vector<game_entry> make_index()
+{
+    Timer t;
+    std::vector<game_entry> ret;
+
+    QFile file(csv_pathname());
+
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qDebug() << "csv: can't open game list for freetrack protocol!";
+        return ret;
+    }
+
+    const QFileInfo info(file);
+    const qint64 mtime = info.lastModified().toMSecsSinceEpoch(), size = info.size();
+    const QString cache_path = cache_pathname();
+
+    bool cached = read_cache(cache_path, mtime, size, ret);
+
+    if (!cached)
+    {
+        ret = read_csv(file);
+        write_cache(cache_path, mtime, size, ret);
     }
 
-    if (id)
-        qDebug() << "unknown game connected" << id;
+    qDebug().nospace() << "csv: " << ret.size() << " games "
+                       << (cached ? "from cache" : "indexed") << " in "
+                       << (int)t.elapsed_ms() << " ms";
+
+    return ret;
+}
+
+// parsed on first use, read-only afterwards so protocol threads can share it
+static const std::vector<game_entry>& game_index()
+{
+    static const std::vector<game_entry> ret = make_index();
+    return ret;
+}
 
-    return false;
+} // ns csv_impl
+
+bool CSV::getGameData(int id, unsigned char* table, QString& gamename)
+{
+    using namespace csv_impl;
+
+    for (int i = 0; i < 8; i++)
+        table[i] = 0;
+
+    if (id != 0)
+        qDebug() << "csv: lookup game id" << id;
+
+    const std::vector<game_entry>& games = game_index();
+
+    auto it = std::lower_bound(games.cbegin(), games.cend(), id,
+                               [](const game_entry& e, int id) { return e.id < id; });
+
+    if (it == games.cend() || it->id != id)
+    {
+        if (id)
+            qDebug() << "unknown game connected" << id;
+        return false;
+    }
+
+    if (it->has_table)
+        std::copy(std::cbegin(it->table), std::cend(it->table), table);
+
+    gamename = it->name;
+    return true;
 }
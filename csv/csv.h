@@ -10,12 +10,14 @@
 class CSV
 {
 public:
+    explicit CSV(QIODevice* device);
+
     QString readLine();
     bool parseLine(QStringList& ret);
 
+    // the game list is parsed once and kept sorted by international id
     static bool getGameData(int gameID, unsigned char* table, QString& gamename);
 private:
-    CSV(QIODevice* device);
 
     QIODevice* m_device;
     QString m_string;
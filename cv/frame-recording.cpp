@@ -0,0 +1,293 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "frame-recording.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <opencv2/imgproc.hpp>
+
+#include <QByteArray>
+#include <QDebug>
+
+namespace frame_recording {
+
+// bump when the layout changes
+static constexpr char magic[8] = { 'o', 't', 'r', 'f', 'r', 'a', 'm', 'e' };
+static constexpr quint32 version = 1;
+
+struct file_header
+{
+    char magic[8];
+    quint32 version, reserved;
+};
+
+struct record_header
+{
+    quint32 size;
+    quint16 w, h;
+    qint64 timestamp_ns;
+};
+
+static_assert(sizeof(file_header) == 16 && sizeof(record_header) == 16);
+
+// the file grows by this much at a time
+static constexpr qint64 map_chunk = 64 << 20;
+
+recorder::recorder(const QString& filename) : file(filename)
+{
+    if (!file.open(QFile::ReadWrite | QFile::Truncate))
+    {
+        qDebug() << "frame recorder: can't open" << filename << file.errorString();
+        return;
+    }
+
+    file_header h {};
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+
+    if (!write(&h, sizeof(h)))
+    {
+        file.close();
+        return;
+    }
+
+    t.start();
+    start(QThread::LowPriority);
+}
+
+recorder::~recorder()
+{
+    requestInterruption();
+    wait();
+
+    if (!file.isOpen())
+        return;
+
+    if (map)
+        file.unmap(map);
+    (void)file.resize(pos);
+    file.close();
+
+    if (dropped())
+        qDebug() << "frame recorder: dropped" << dropped() << "frames";
+}
+
+void recorder::push(const cv::Mat& frame)
+{
+    if (!file.isOpen() || frame.empty())
+        return;
+
+    if (!free_slots.tryAcquire())
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    slot& s = slots[write_idx];
+    write_idx = (write_idx + 1) % queue_size;
+
+    s.timestamp_ns = t.elapsed_nsecs();
+
+    if (frame.channels() == 3)
+        cv::cvtColor(frame, s.gray, cv::COLOR_BGR2GRAY);
+    else
+        frame.copyTo(s.gray);
+
+    used_slots.release();
+}
+
+void recorder::run()
+{
+    std::vector<uchar> delta;
+
+    for (;;)
+    {
+        if (!used_slots.tryAcquire(1, 100))
+        {
+            if (isInterruptionRequested())
+                break;
+            continue;
+        }
+
+        slot& s = slots[read_idx];
+        read_idx = (read_idx + 1) % queue_size;
+
+        const int w = s.gray.cols, h = s.gray.rows;
+        delta.resize(unsigned(w * h));
+
+        // the sensor's background is smooth, deltas from the left
+        // neighbor are mostly small and deflate well
+        for (int y = 0; y < h; y++)
+        {
+            const uchar* in = s.gray.ptr<uchar>(y);
+            uchar* out = &delta[unsigned(y * w)];
+
+            out[0] = in[0];
+            for (int x = 1; x < w; x++)
+                out[x] = uchar(in[x] - in[x-1]);
+        }
+
+        const QByteArray compressed = qCompress(delta.data(), int(delta.size()), 1);
+        const record_header r { quint32(compressed.size()), quint16(w), quint16(h), s.timestamp_ns };
+
+        free_slots.release();
+
+        if (!write(&r, sizeof(r)) || !write(compressed.constData(), compressed.size()))
+        {
+            qDebug() << "frame recorder: write failed, stopping" << file.errorString();
+            break;
+        }
+    }
+}
+
+bool recorder::remap(qint64 at)
+{
+    if (map)
+        file.unmap(map);
+
+    map = nullptr;
+
+    if (!file.resize(at + map_chunk))
+        return false;
+
+    map = file.map(at, map_chunk);
+    map_offset = at;
+    map_size = map_chunk;
+
+    return map != nullptr;
+}
+
+bool recorder::write(const void* data_, qint64 len)
+{
+    auto data = (const uchar*)data_;
+
+    while (len > 0)
+    {
+        if (!map || pos >= map_offset + map_size)
+            if (!remap(pos))
+                return false;
+
+        const qint64 n = std::min(len, map_offset + map_size - pos);
+        std::memcpy(map + (pos - map_offset), data, size_t(n));
+
+        pos += n; data += n; len -= n;
+    }
+
+    return true;
+}
+
+replay::~replay()
+{
+    close();
+}
+
+void replay::close()
+{
+    if (data)
+        file.unmap(const_cast<uchar*>(data));
+    data = nullptr;
+    index.clear();
+    file.close();
+}
+
+bool replay::open(const QString& filename)
+{
+    close();
+
+    file.setFileName(filename);
+
+    if (!file.open(QFile::ReadOnly))
+    {
+        qDebug() << "frame replay: can't open" << filename << file.errorString();
+        return false;
+    }
+
+    const qint64 size = file.size();
+    file_header h {};
+
+    if (size < qint64(sizeof(h)) || !(data = file.map(0, size)))
+    {
+        qDebug() << "frame replay: can't map" << filename;
+        close();
+        return false;
+    }
+
+    std::memcpy(&h, data, sizeof(h));
+
+    if (std::memcmp(h.magic, magic, sizeof(magic)) || h.version != version)
+    {
+        qDebug() << "frame replay:" << filename << "isn't a frame recording";
+        close();
+        return false;
+    }
+
+    for (qint64 pos = sizeof(h); pos + qint64(sizeof(record_header)) <= size; )
+    {
+        record_header r;
+        std::memcpy(&r, data + pos, sizeof(r));
+        pos += sizeof(r);
+
+        // a recording that was cut short
+        if (pos + r.size > size || r.w == 0 || r.h == 0)
+            break;
+
+        index.push_back({ pos, r.size, r.w, r.h, r.timestamp_ns });
+        pos += r.size;
+    }
+
+    if (index.empty())
+    {
+        qDebug() << "frame replay:" << filename << "has no frames";
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+double replay::fps() const
+{
+    if (index.size() < 2)
+        return 0;
+
+    const std::int64_t dt = index.back().timestamp_ns - index.front().timestamp_ns;
+
+    if (dt <= 0)
+        return 0;
+
+    return (index.size() - 1) * 1e9 / dt;
+}
+
+bool replay::read(unsigned k, cv::Mat1b& gray)
+{
+    if (k >= index.size())
+        return false;
+
+    const entry& e = index[k];
+    const QByteArray delta = qUncompress(data + e.offset, int(e.size));
+
+    if (delta.size() != e.w * e.h)
+        return false;
+
+    gray.create(e.h, e.w);
+
+    for (int y = 0; y < e.h; y++)
+    {
+        auto in = (const uchar*)delta.constData() + y * e.w;
+        uchar* out = gray.ptr<uchar>(y);
+
+        uchar x0 = 0;
+        for (int x = 0; x < e.w; x++)
+            out[x] = x0 = uchar(x0 + in[x]);
+    }
+
+    return true;
+}
+
+} // ns frame_recording
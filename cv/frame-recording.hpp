@@ -0,0 +1,98 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// Raw camera frames for reproducing tracking problems. Frames are stored
+// grayscale, each row delta-coded and the frame deflated, with the capture
+// time in nanoseconds since the recording started.
+
+#include "compat/timer.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <QFile>
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+
+namespace frame_recording {
+
+// compresses and writes on its own thread, through a mapped window of the file
+class recorder final : QThread
+{
+    static constexpr unsigned queue_size = 8;
+
+    struct slot
+    {
+        cv::Mat1b gray;
+        std::int64_t timestamp_ns = 0;
+    };
+
+    std::array<slot, queue_size> slots;
+    unsigned write_idx = 0, read_idx = 0;
+    QSemaphore free_slots { queue_size }, used_slots;
+    std::atomic<unsigned> dropped_ { 0 };
+
+    Timer t;
+    QFile file;
+    uchar* map = nullptr;
+    qint64 map_offset = 0, map_size = 0, pos = 0;
+
+    void run() override;
+    bool write(const void* data, qint64 len);
+    bool remap(qint64 at);
+
+public:
+    explicit recorder(const QString& filename);
+    ~recorder() override;
+
+    bool is_open() const { return file.isOpen(); }
+    QString filename() const { return file.fileName(); }
+    // capture thread, never blocks. when the writer falls behind the
+    // frame is dropped rather than stalling the tracker.
+    void push(const cv::Mat& frame);
+    unsigned dropped() const { return dropped_.load(std::memory_order_relaxed); }
+};
+
+class replay final
+{
+    struct entry
+    {
+        qint64 offset;
+        quint32 size;
+        int w, h;
+        std::int64_t timestamp_ns;
+    };
+
+    QFile file;
+    const uchar* data = nullptr;
+    std::vector<entry> index;
+    std::vector<uchar> row;
+
+public:
+    replay() = default;
+    ~replay();
+
+    bool open(const QString& filename);
+    void close();
+
+    unsigned size() const { return (unsigned)index.size(); }
+    std::int64_t timestamp_ns(unsigned k) const { return index[k].timestamp_ns; }
+    cv::Size frame_size(unsigned k) const { return { index[k].w, index[k].h }; }
+    // mean rate over the whole recording
+    double fps() const;
+
+    bool read(unsigned k, cv::Mat1b& gray);
+};
+
+} // ns frame_recording
@@ -0,0 +1,292 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "lens-distortion.hpp"
+#include "options/options.hpp"
+#include "compat/math.hpp"
+
+#include <cmath>
+#include <iterator>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <QDebug>
+
+namespace lens_distortion {
+
+using namespace options;
+
+// bumped on store() and forget() so running trackers pick up the change
+static std::atomic<unsigned> generation_counter { 0 };
+
+static constexpr int nfields = 10;
+
+static QString key_for(const QString& camera_name)
+{
+    // QSettings would read slashes as groups
+    QString ret = camera_name;
+    ret.replace('/', '_').replace('\\', '_');
+    return QStringLiteral("camera-") + ret;
+}
+
+struct settings final : opts
+{
+    value<QList<double>> coeffs;
+    explicit settings(const QString& camera_name);
+};
+
+settings::settings(const QString& camera_name) :
+    opts("lens-distortion"),
+    coeffs { b, key_for(camera_name), {} }
+{}
+
+bool model::fits(int w, int h) const
+{
+    return is_valid() && w > 0 && h > 0 && std::fabs(h / (double)w - aspect) < 1e-2;
+}
+
+cv::Matx33d model::intrinsics(int w_) const
+{
+    const double w = w_;
+    return { fx * w, 0, cx * w,
+             0, fy * w, cy * w,
+             0, 0, 1 };
+}
+
+double model::fov(int w, int h) const
+{
+    const double diag = std::sqrt(w*(double)w + h*(double)h) / w;
+    return 2 * std::atan(diag / 2 / std::sqrt(fx * fy)) * 180 / M_PI;
+}
+
+model load(const QString& camera_name)
+{
+    model ret;
+
+    if (camera_name.isEmpty())
+        return ret;
+
+    const QList<double> x = *settings(camera_name).coeffs;
+
+    if (x.size() != nfields)
+        return ret;
+
+    ret.fx = x[0]; ret.fy = x[1];
+    ret.cx = x[2]; ret.cy = x[3];
+    ret.aspect = x[4];
+    for (unsigned i = 0; i < std::size(ret.k); i++)
+        ret.k[i] = x[5 + (int)i];
+
+    if (!ret.is_valid())
+        return {};
+
+    return ret;
+}
+
+void store(const QString& camera_name, const model& m)
+{
+    if (camera_name.isEmpty())
+        return;
+
+    QList<double> x { m.fx, m.fy, m.cx, m.cy, m.aspect };
+    for (double k : m.k)
+        x.append(k);
+
+    settings s(camera_name);
+    s.coeffs = x;
+    s.b->save();
+
+    generation_counter++;
+}
+
+void forget(const QString& camera_name)
+{
+    if (camera_name.isEmpty())
+        return;
+
+    settings s(camera_name);
+    s.coeffs = QList<double>{};
+    s.b->save();
+
+    generation_counter++;
+}
+
+void undistorter::update(const QString& camera_name, int w_, int h_, double fov_)
+{
+    const unsigned gen = generation_counter;
+
+    if (gen == generation && w_ == w && h_ == h && fov_ == fov && camera_name == name)
+        return;
+
+    generation = gen;
+    name = camera_name;
+    w = w_; h = h_;
+    fov = fov_;
+    grid.clear();
+
+    const model m = load(camera_name);
+
+    if (!m.is_valid())
+        return;
+
+    if (!(fov > 0 && fov < 180))
+        return;
+
+    if (!m.fits(w, h))
+    {
+        qDebug() << "lens distortion: calibrated for another aspect ratio, ignoring for"
+                 << camera_name << w << "x" << h;
+        return;
+    }
+
+    grid_w = (w + cell - 1) / cell + 1;
+    const int grid_h = (h + cell - 1) / cell + 1;
+
+    std::vector<cv::Point2f> src;
+    src.reserve(unsigned(grid_w * grid_h));
+
+    for (int j = 0; j < grid_h; j++)
+        for (int i = 0; i < grid_w; i++)
+            src.emplace_back(float(i * cell), float(j * cell));
+
+    const cv::Matx33d K = m.intrinsics(w);
+    const cv::Mat1d D(1, 5, const_cast<double*>(m.k));
+
+    // back into pixels of the tracker's own pinhole model, centered, with
+    // square pixels and the tracker's field of view. that's the model's
+    // own after calibrating, the setting being rounded doesn't matter.
+    const double f = std::sqrt(w*(double)w + h*(double)h) / (2 * std::tan(fov * M_PI / 360));
+    const cv::Matx33d P { f, 0, w * .5,
+                          0, f, h * .5,
+                          0, 0, 1 };
+
+    cv::undistortPoints(src, grid, K, D, cv::noArray(), P);
+
+    qDebug() << "lens distortion: using model for" << camera_name << w << "x" << h;
+}
+
+cv::Point2f undistorter::operator()(cv::Point2f pt) const
+{
+    if (grid.empty())
+        return pt;
+
+    const int grid_h = int(grid.size()) / grid_w;
+
+    const float x = clamp(pt.x / cell, 0.f, float(grid_w - 1) - 1e-3f);
+    const float y = clamp(pt.y / cell, 0.f, float(grid_h - 1) - 1e-3f);
+    const int i = int(x), j = int(y);
+    const float fx = x - i, fy = y - j;
+
+    const cv::Point2f* row0 = &grid[unsigned(j * grid_w + i)];
+    const cv::Point2f* row1 = row0 + grid_w;
+
+    const cv::Point2f top = row0[0] * (1 - fx) + row0[1] * fx;
+    const cv::Point2f bottom = row1[0] * (1 - fx) + row1[1] * fx;
+
+    return top * (1 - fy) + bottom * fy;
+}
+
+void undistorter::undistort(cv::Point2f* points, unsigned npoints) const
+{
+    if (grid.empty())
+        return;
+
+    for (unsigned k = 0; k < npoints; k++)
+        points[k] = (*this)(points[k]);
+}
+
+calibrator::calibrator(cv::Size pattern) : pattern(pattern)
+{
+}
+
+void calibrator::reset()
+{
+    views.clear();
+    w = 0; h = 0;
+}
+
+bool calibrator::is_new_view(const std::vector<cv::Point2f>& pts) const
+{
+    // the board has to have moved by a tenth of the frame since each of
+    // the previous views, otherwise the fit is dominated by one position
+    const float min_dist = w * .1f;
+
+    for (const auto& view : views)
+    {
+        float dist = 0;
+        for (unsigned k = 0; k < pts.size(); k++)
+            dist += (float)cv::norm(pts[k] - view[k]);
+        if (dist / pts.size() < min_dist)
+            return false;
+    }
+
+    return true;
+}
+
+bool calibrator::add_view(const cv::Mat& gray)
+{
+    if (gray.empty() || gray.type() != CV_8UC1)
+        return false;
+
+    if (gray.cols != w || gray.rows != h)
+    {
+        // the camera was reopened at another resolution
+        views.clear();
+        w = gray.cols; h = gray.rows;
+    }
+
+    corners.clear();
+
+    if (!cv::findChessboardCorners(gray, pattern, corners,
+                                   cv::CALIB_CB_ADAPTIVE_THRESH | cv::CALIB_CB_NORMALIZE_IMAGE | cv::CALIB_CB_FAST_CHECK))
+        return false;
+
+    if (!is_new_view(corners))
+        return false;
+
+    cv::cornerSubPix(gray, corners, { 5, 5 }, { -1, -1 },
+                     { cv::TermCriteria::EPS | cv::TermCriteria::COUNT, 30, .01 });
+
+    views.push_back(corners);
+
+    return true;
+}
+
+bool calibrator::calibrate(model& ret, double& rms) const
+{
+    if (views.size() < min_views)
+        return false;
+
+    std::vector<cv::Point3f> board;
+    board.reserve(unsigned(pattern.area()));
+    for (int j = 0; j < pattern.height; j++)
+        for (int i = 0; i < pattern.width; i++)
+            board.emplace_back(float(i), float(j), 0.f);
+
+    const std::vector<std::vector<cv::Point3f>> objects(views.size(), board);
+
+    cv::Matx33d K;
+    cv::Mat1d D;
+    std::vector<cv::Mat> rvecs, tvecs;
+
+    // k3 only helps fisheye lenses and overfits with this few views
+    rms = cv::calibrateCamera(objects, views, { w, h }, K, D, rvecs, tvecs, cv::CALIB_FIX_K3);
+
+    if (!std::isfinite(rms) || D.total() < 5)
+        return false;
+
+    ret.fx = K(0, 0) / w; ret.fy = K(1, 1) / w;
+    ret.cx = K(0, 2) / w; ret.cy = K(1, 2) / w;
+    ret.aspect = h / (double)w;
+    for (unsigned i = 0; i < std::size(ret.k); i++)
+        ret.k[i] = D((int)i);
+
+    return ret.is_valid();
+}
+
+} // ns lens_distortion
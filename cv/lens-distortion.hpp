@@ -0,0 +1,93 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// Lens distortion for trackers that only need a few points corrected.
+// Frames are never remapped, extracted points go through a grid of
+// undistorted positions computed once per camera and resolution.
+
+#include <atomic>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <QString>
+
+namespace lens_distortion {
+
+// OpenCV's pinhole model with k1, k2, p1, p2, k3. the intrinsics are
+// divided by the frame's width, so that a camera's other resolutions of
+// the same aspect ratio use the same model.
+struct model final
+{
+    double fx = 0, fy = 0, cx = 0, cy = 0, aspect = 0;
+    double k[5] {};
+
+    bool is_valid() const { return fx > 0 && fy > 0 && aspect > 0; }
+    // false for an aspect ratio other than calibrated for
+    bool fits(int w, int h) const;
+    cv::Matx33d intrinsics(int w) const;
+    // diagonal field of view in degrees, for the trackers' own setting
+    double fov(int w, int h) const;
+};
+
+// stored per camera name, the trackers look up their camera's
+[[nodiscard]] model load(const QString& camera_name);
+void store(const QString& camera_name, const model& m);
+void forget(const QString& camera_name);
+
+class undistorter final
+{
+    static constexpr int cell = 16;
+
+    QString name;
+    int w = 0, h = 0;
+    double fov = 0;
+    unsigned generation = -1u;
+    int grid_w = 0;
+    // undistorted position of every cell's corner
+    std::vector<cv::Point2f> grid;
+
+public:
+    // reloads the model when the camera, resolution, field of view or
+    // stored models changed, otherwise free. call before every frame's
+    // points. `fov' is the tracker's own diagonal field of view in degrees,
+    // points land where its pinhole model expects them.
+    void update(const QString& camera_name, int w, int h, double fov);
+    bool is_enabled() const { return !grid.empty(); }
+
+    // in pixels, bilinear between the grid's points
+    cv::Point2f operator()(cv::Point2f pt) const;
+    void undistort(cv::Point2f* points, unsigned npoints) const;
+};
+
+// fits a model to views of a chessboard, 9x6 inner corners by default
+class calibrator final
+{
+    cv::Size pattern;
+    std::vector<std::vector<cv::Point2f>> views;
+    std::vector<cv::Point2f> corners;
+    int w = 0, h = 0;
+
+    bool is_new_view(const std::vector<cv::Point2f>& pts) const;
+
+public:
+    static constexpr unsigned min_views = 10;
+
+    explicit calibrator(cv::Size pattern = { 9, 6 });
+
+    // returns true if the frame had the chessboard in a new position.
+    // takes tens of milliseconds, don't call for every frame.
+    bool add_view(const cv::Mat& gray);
+    unsigned view_count() const { return (unsigned)views.size(); }
+    // rms is the reprojection error in pixels
+    [[nodiscard]] bool calibrate(model& ret, double& rms) const;
+    void reset();
+};
+
+} // ns lens_distortion
@@ -2,77 +2,55 @@
 
 #include <opencv2/imgproc.hpp>
 
-void cv_video_widget::update_image(const cv::Mat& frame)
+using namespace time_units;
+
+cv::Mat cv_video_widget::as_mat(QImage& texture)
 {
-    QMutexLocker l(&mtx);
+    return cv::Mat(texture.height(), texture.width(), CV_8UC4,
+                   texture.bits(), (size_t)texture.bytesPerLine());
+}
 
-    if (freshp)
+void cv_video_widget::update_image(const cv::Mat& frame)
+{
+    if (frame.rows < 1 || frame.cols < 1)
         return;
 
-    if (W < 1 || H < 1 || frame.rows < 1 || frame.cols < 1)
-        return;
+    Timer t;
 
-    cv::Mat const* __restrict frame_scaled = nullptr;
+    QImage* texture = begin_update();
 
-    if (frame3.cols != W || frame3.rows != H)
-    {
-        frame3 = cv::Mat(H, W, frame.type());
-        frame2 = cv::Mat(H, W, CV_8UC4);
+    if (!texture)
+        return;
 
-        if (!frame2.isContinuous() || !frame3.isContinuous())
-            std::abort();
-    }
+    cv::Mat dest = as_mat(*texture);
+    cv::Mat const* src = &frame;
 
-    if (frame.cols != W || frame.rows != H)
+    // scale first, converting fewer channels is cheaper
+    if (frame.cols != dest.cols || frame.rows != dest.rows)
     {
-        cv::resize(frame, frame3, { W, H }, 0, 0, cv::INTER_NEAREST);
-        frame_scaled = &frame3;
+        cv::resize(frame, frame_scaled, dest.size(), 0, 0, cv::INTER_NEAREST);
+        src = &frame_scaled;
     }
-    else if (!frame.isContinuous())
-    {
-        frame.copyTo(frame3);
-        frame_scaled = &frame3;
-    }
-    else
-        frame_scaled = &frame;
-
-    freshp = true;
 
-    int color_cvt = 0;
-    constexpr int nchannels = 4;
-
-    switch (frame_scaled->channels())
+    // destination is preallocated with matching size and type,
+    // so neither call reallocates it
+    switch (src->channels())
     {
     case 1:
-        color_cvt = cv::COLOR_GRAY2BGRA;
+        cv::cvtColor(*src, dest, cv::COLOR_GRAY2BGRA);
         break;
     case 3:
-        color_cvt = cv::COLOR_BGR2BGRA;
+        cv::cvtColor(*src, dest, cv::COLOR_BGR2BGRA);
         break;
-    case nchannels:
+    case 4:
+        src->copyTo(dest);
         break;
     default:
         unreachable();
         break;
     }
 
-    cv::Mat const* frame_color;
-
-    if (color_cvt != cv::COLOR_COLORCVT_MAX)
-    {
-        cv::cvtColor(*frame_scaled, frame2, color_cvt);
-        frame_color = &frame2;
-    }
-    else
-        frame_color = frame_scaled;
-
-    int stride = frame_color->step.p[0], rows = frame_color->rows;
-    unsigned nbytes = (unsigned)(rows * stride);
-    vec.resize(nbytes); vec.shrink_to_fit();
-    std::memcpy(vec.data(), frame_color->data, nbytes);
-
-    texture = QImage((const unsigned char*) vec.data(), W, H, stride, QImage::Format_ARGB32);
-    texture.setDevicePixelRatio(devicePixelRatioF());
+    end_update(t.elapsed<ms>());
 }
 
 cv_video_widget::cv_video_widget(QWidget* parent) : video_widget(parent) {}
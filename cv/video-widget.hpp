@@ -15,6 +15,9 @@ struct cv_video_widget final : video_widget
     cv_video_widget(QWidget* parent = nullptr);
     void update_image(const cv::Mat& frame);
 
+    // wraps the texture from begin_update() without copying
+    static cv::Mat as_mat(QImage& texture);
+
 private:
-    cv::Mat frame2, frame3;
+    cv::Mat frame_scaled;
 };
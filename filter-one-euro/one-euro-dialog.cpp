@@ -0,0 +1,28 @@
+#include "one-euro.hpp"
+
+dialog_one_euro::dialog_one_euro()
+{
+    ui.setupUi(this);
+
+    connect(ui.buttonBox, SIGNAL(accepted()), this, SLOT(doOK()));
+    connect(ui.buttonBox, SIGNAL(rejected()), this, SLOT(doCancel()));
+
+    tie_setting(s.rot_min_cutoff, ui.rot_min_cutoff);
+    tie_setting(s.rot_beta, ui.rot_beta);
+    tie_setting(s.rot_d_cutoff, ui.rot_d_cutoff);
+
+    tie_setting(s.pos_min_cutoff, ui.pos_min_cutoff);
+    tie_setting(s.pos_beta, ui.pos_beta);
+    tie_setting(s.pos_d_cutoff, ui.pos_d_cutoff);
+}
+
+void dialog_one_euro::doOK()
+{
+    s.b->save();
+    close();
+}
+
+void dialog_one_euro::doCancel()
+{
+    close();
+}
@@ -0,0 +1,77 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "one-euro.hpp"
+#include "compat/math.hpp"
+
+#include <cmath>
+
+// One Euro filter, Casiez, Roussel & Vogel, CHI 2012.
+//
+// A first-order low-pass whose cutoff rises with the (itself low-passed)
+// speed of the axis: at rest the cutoff sits at min_cutoff and jitter is
+// smoothed heavily, while moving it grows by beta * speed so lag stays
+// small. No spline lookups and no pow() -- the smoothing factors only
+// need a division per axis.
+
+static constexpr double tau = 2 * M_PI;
+
+one_euro::one_euro() = default;
+
+void one_euro::filter(const double* input, double* output)
+{
+    if (first_run)
+    {
+        first_run = false;
+        timer.start();
+
+        for (unsigned i = 0; i < 6; i++)
+        {
+            output[i] = last_output[i] = input[i];
+            last_deriv[i] = 0;
+        }
+
+        return;
+    }
+
+    // a tick that came too soon or after a stall shouldn't blow up the derivative
+    const double dt = clamp(timer.elapsed_seconds(), 1e-4, .1);
+    timer.start();
+
+    // each read locks the bundle, once per tick and not per axis
+    const double pos_min_cutoff = *s.pos_min_cutoff, pos_beta = *s.pos_beta, pos_d_cutoff = *s.pos_d_cutoff;
+    const double rot_min_cutoff = *s.rot_min_cutoff, rot_beta = *s.rot_beta, rot_d_cutoff = *s.rot_d_cutoff;
+
+    for (unsigned i = 0; i < 3; i++)
+    {
+        min_cutoff[i] = pos_min_cutoff;
+        beta[i] = pos_beta;
+        d_cutoff[i] = pos_d_cutoff;
+
+        min_cutoff[i+3] = rot_min_cutoff;
+        beta[i+3] = rot_beta;
+        d_cutoff[i+3] = rot_d_cutoff;
+    }
+
+    // alpha = dt / (dt + 1/(2 pi fc)) = 1 / (1 + 1/(2 pi fc dt))
+    const double inv_dt = 1 / dt;
+
+    for (unsigned i = 0; i < 6; i++)
+    {
+        const double deriv = (input[i] - last_output[i]) * inv_dt;
+        const double alpha_d = 1 / (1 + inv_dt / (tau * d_cutoff[i]));
+        const double deriv_hat = last_deriv[i] + alpha_d * (deriv - last_deriv[i]);
+
+        const double cutoff = min_cutoff[i] + beta[i] * std::fabs(deriv_hat);
+        const double alpha = 1 / (1 + inv_dt / (tau * cutoff));
+
+        last_deriv[i] = deriv_hat;
+        output[i] = last_output[i] = last_output[i] + alpha * (input[i] - last_output[i]);
+    }
+}
+
+OPENTRACK_DECLARE_FILTER(one_euro, dialog_one_euro, one_euroDll)
@@ -0,0 +1,72 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include "api/plugin-api.hpp"
+#include "compat/timer.hpp"
+#include "options/options.hpp"
+#include "ui_one-euro.h"
+
+using namespace options;
+
+struct settings_one_euro : opts
+{
+    // cutoffs are in Hz, beta in 1/units of the axis' speed, i.e.
+    // degrees/s for rotation and centimeters/s for position
+    value<double> rot_min_cutoff { b, "rotation-min-cutoff", 1 },
+                  rot_beta { b, "rotation-beta", .02 },
+                  rot_d_cutoff { b, "rotation-derivative-cutoff", 1 };
+
+    value<double> pos_min_cutoff { b, "position-min-cutoff", 1 },
+                  pos_beta { b, "position-beta", .05 },
+                  pos_d_cutoff { b, "position-derivative-cutoff", 1 };
+
+    settings_one_euro() : opts("one-euro-filter") {}
+};
+
+class one_euro : public IFilter
+{
+    // per-axis parameters, laid out like the pose so the loop has no branches
+    double min_cutoff[6], beta[6], d_cutoff[6];
+    double last_output[6], last_deriv[6];
+
+    settings_one_euro s;
+    Timer timer;
+    bool first_run = true;
+
+public:
+    one_euro();
+    void filter(const double* input, double* output) override;
+    void center() override { first_run = true; }
+    module_status initialize() override { return status_ok(); }
+};
+
+class dialog_one_euro : public IFilterDialog
+{
+    Q_OBJECT
+
+    Ui::UI_one_euro ui;
+    settings_one_euro s;
+
+public:
+    dialog_one_euro();
+    void register_filter(IFilter*) override {}
+    void unregister_filter() override {}
+
+private slots:
+    void doOK();
+    void doCancel();
+};
+
+class one_euroDll : public Metadata
+{
+    Q_OBJECT
+
+    QString name() override { return tr("One Euro"); }
+    QIcon icon() override { return QIcon(":/images/filter-16.png"); }
+};
@@ -288,6 +288,9 @@ int otr_main(int argc, char** argv, std::function<std::unique_ptr<QWidget>()> co
 
     int ret = run_window(make_main_window());
 
+    // whatever the main window's destructor saved
+    options::globals::flush_pending_saves();
+
 #if 0
     // msvc crashes in Qt plugin system's dtor
     // Note: QLibrary::PreventUnloadHint seems to workaround it
@@ -0,0 +1,173 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "headless.hpp"
+#include "api/plugin-api.hpp"
+#include "options/scoped.hpp"
+#include "compat/library-path.hpp"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QDebug>
+
+using namespace time_units;
+
+static volatile std::sig_atomic_t quit_requested = 0;
+
+static void on_signal(int)
+{
+    quit_requested = 1;
+}
+
+void headless::install_signal_handlers()
+{
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+}
+
+headless::headless(const args& a) :
+    State(OPENTRACK_BASE_PATH + OPENTRACK_LIBRARY_PATH),
+    report_host(a.host),
+    report_port(a.port),
+    to_stdout(!a.quiet),
+    with_timings(a.timings)
+{
+    connect(&report_timer, &QTimer::timeout, this, &headless::report);
+    connect(&signal_timer, &QTimer::timeout, this, &headless::poll_signals);
+
+    report_timer.setInterval(std::max(10, a.interval_ms));
+    signal_timer.start(100);
+}
+
+headless::~headless()
+{
+    stop();
+}
+
+bool headless::start()
+{
+    if (work)
+        return true;
+
+    // null frame: trackers run without preview, no dialogs get shown
+    work = std::make_shared<Work>(pose, ev, nullptr, current_tracker(), current_protocol(), current_filter(),
+                                  current_extra_protocols());
+
+    if (!work->is_ok())
+    {
+        work = nullptr;
+        return false;
+    }
+
+    qDebug().nospace() << "headless: started in " << (int)uptime.elapsed_ms() << " ms";
+
+    (void)work->pipeline_.get_tick_stats();
+    last_timings = work->pipeline_.get_stage_timings();
+    report_timer.start();
+
+    return true;
+}
+
+void headless::stop()
+{
+    report_timer.stop();
+
+    if (!work)
+        return;
+
+    with_tracker_teardown sentinel;
+    work = nullptr;
+}
+
+QString headless::status_line()
+{
+    double mapped[6] {}, raw[6] {};
+    work->pipeline_.raw_and_mapped_pose(mapped, raw);
+
+    const tick_stats st = work->pipeline_.get_tick_stats();
+    const double dt = report_timer.interval() * 1e-3;
+
+    QString game;
+    if (work->libs.pProtocol)
+        game = work->libs.pProtocol->game_name();
+
+    QString line;
+    line.reserve(256);
+
+    line += QStringLiteral("rate=%1Hz tick-mean=%2ms tick-max=%3ms")
+                .arg(st.ticks / dt, 0, 'f', 1)
+                .arg(st.mean_ms, 0, 'f', 3)
+                .arg(st.max_ms, 0, 'f', 3);
+
+    line += QStringLiteral(" game=\"%1\"").arg(game);
+
+    line += QStringLiteral(" raw=");
+    for (unsigned k = 0; k < 6; k++)
+        line += QStringLiteral("%1%2").arg(k ? "," : "").arg(raw[k], 0, 'f', 2);
+
+    line += QStringLiteral(" mapped=");
+    for (unsigned k = 0; k < 6; k++)
+        line += QStringLiteral("%1%2").arg(k ? "," : "").arg(mapped[k], 0, 'f', 2);
+
+    for (const auto& p : work->pipeline_.get_protocol_stats())
+        line += QStringLiteral(" proto=\"%1\":sent=%2,dropped=%3,latency-mean=%4ms,latency-max=%5ms")
+                    .arg(p.name).arg(p.delivered).arg(p.dropped)
+                    .arg(p.mean_ms, 0, 'f', 3).arg(p.max_ms, 0, 'f', 3);
+
+    if (with_timings)
+    {
+        using namespace pipeline_impl;
+
+        const stage_timings::snapshot_t cur = work->pipeline_.get_stage_timings();
+
+        // p50/p99/max in milliseconds over the last interval
+        for (unsigned k = 0; k < (unsigned)stage::COUNT; k++)
+        {
+            const histogram_snapshot h = cur[k] - last_timings[k];
+            line += QStringLiteral(" %1=%2/%3/%4")
+                        .arg(stage_name(stage(k)))
+                        .arg(h.percentile_ms(.5), 0, 'f', 3)
+                        .arg(h.percentile_ms(.99), 0, 'f', 3)
+                        .arg(h.max_ms(), 0, 'f', 3);
+        }
+
+        last_timings = cur;
+    }
+
+    return line;
+}
+
+void headless::report()
+{
+    if (!work)
+        return;
+
+    const QByteArray line = status_line().toUtf8();
+
+    if (to_stdout)
+    {
+        std::fprintf(stdout, "%s\n", line.constData());
+        std::fflush(stdout);
+    }
+
+    if (report_port != 0)
+        (void)sock.writeDatagram(line, report_host, report_port);
+}
+
+void headless::poll_signals()
+{
+    if (!quit_requested)
+        return;
+
+    signal_timer.stop();
+    qDebug() << "headless: exiting on signal";
+    stop();
+    QCoreApplication::quit();
+}
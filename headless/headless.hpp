@@ -0,0 +1,52 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include "logic/state.hpp"
+#include "compat/timer.hpp"
+
+#include <QObject>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QString>
+
+class headless final : public QObject, private State
+{
+    Q_OBJECT
+
+    QTimer report_timer, signal_timer;
+    QUdpSocket sock;
+    QHostAddress report_host;
+    quint16 report_port = 0;
+    Timer uptime;
+    bool to_stdout = true, with_timings = false;
+    pipeline_impl::stage_timings::snapshot_t last_timings;
+
+    QString status_line();
+    void report();
+    void poll_signals();
+
+public:
+    struct args
+    {
+        int interval_ms = 1000;
+        QHostAddress host;
+        quint16 port = 0;
+        bool quiet = false;
+        bool timings = false;
+    };
+
+    explicit headless(const args& a);
+    ~headless() override;
+
+    bool start();
+    void stop();
+
+    static void install_signal_handlers();
+};
@@ -0,0 +1,145 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "headless.hpp"
+#include "migration/migration.hpp"
+#include "options/globals.hpp"
+#include "compat/library-path.hpp"
+#include "compat/sysexits.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+
+extern "C" const char* const opentrack_version;
+
+#ifdef __clang__
+#   pragma GCC diagnostic ignored "-Wmain"
+#endif
+
+static void qdebug_to_stderr(QtMsgType, const QMessageLogContext&, const QString& msg)
+{
+    std::fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    std::fflush(stderr);
+}
+
+static bool parse_udp(const QString& str, headless::args& a)
+{
+    const int idx = str.lastIndexOf(':');
+    if (idx < 1)
+        return false;
+
+    bool ok = false;
+    const unsigned port = str.midRef(idx + 1).toUInt(&ok);
+    if (!ok || port == 0 || port > 65535)
+        return false;
+
+    if (!a.host.setAddress(str.left(idx)))
+        return false;
+    a.port = (quint16)port;
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+#if !defined _WIN32 && !defined __APPLE__
+    // trackers still link against QtWidgets, don't require a display for that
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationVersion(opentrack_version);
+
+    (void)qInstallMessageHandler(qdebug_to_stderr);
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Run the opentrack pipeline without a user interface.");
+    p.addHelpOption();
+    p.addVersionOption();
+
+    QCommandLineOption profile_opt("profile", "Profile name or path to an .ini file.", "profile");
+    QCommandLineOption interval_opt("interval", "Status report interval in milliseconds.", "ms", "1000");
+    QCommandLineOption udp_opt("udp", "Also send status reports to this host:port over UDP.", "address");
+    QCommandLineOption quiet_opt({ "q", "quiet" }, "Don't print status reports to standard output.");
+    QCommandLineOption timings_opt("timings", "Report p50/p99/max time of each pipeline stage.");
+
+    p.addOptions({ profile_opt, interval_opt, udp_opt, quiet_opt, timings_opt });
+    p.process(app);
+
+    headless::args a;
+
+    {
+        bool ok = false;
+        a.interval_ms = p.value(interval_opt).toInt(&ok);
+        if (!ok || a.interval_ms <= 0)
+        {
+            qDebug() << "headless: bad --interval" << p.value(interval_opt);
+            return EX_USAGE;
+        }
+    }
+
+    if (p.isSet(udp_opt) && !parse_udp(p.value(udp_opt), a))
+    {
+        qDebug() << "headless: bad --udp address, expected host:port" << p.value(udp_opt);
+        return EX_USAGE;
+    }
+
+    a.quiet = p.isSet(quiet_opt);
+    a.timings = p.isSet(timings_opt);
+
+    if (p.isSet(profile_opt))
+    {
+        using namespace options::globals;
+
+        const QString name = p.value(profile_opt);
+        QString path;
+
+        // resolve relative paths before changing the working directory
+        if (name.contains('/') || name.contains('\\'))
+            path = QFileInfo(name).absoluteFilePath();
+        else
+            path = ini_combine(name.endsWith(".ini") ? name : name + ".ini");
+
+        if (!QFileInfo(path).isFile())
+        {
+            qDebug() << "headless: no such profile" << path;
+            return EX_NOINPUT;
+        }
+
+        force_ini_pathname(path);
+    }
+
+    QDir::setCurrent(OPENTRACK_BASE_PATH);
+
+    qDebug() << "opentrack" << opentrack_version << "profile" << options::globals::ini_pathname();
+
+    (void)run_migrations();
+
+    headless::install_signal_handlers();
+
+    int ret = EX_SOFTWARE;
+
+    {
+        headless h(a);
+
+        if (h.start())
+            ret = QApplication::exec();
+    }
+
+    // while QApplication's still around, the writer thread may not be
+    // by the time of static destruction
+    options::globals::flush_pending_saves();
+
+    return ret;
+}
@@ -37,6 +37,9 @@ event_handler::event_handler(Modules::dylib_list const& extensions) : ext_bundle
 {
     for (std::shared_ptr<dylib> const& lib : extensions)
     {
+        if (!lib->load())
+            continue;
+
         std::shared_ptr<IExtension> ext(reinterpret_cast<IExtension*>(lib->Constructor()));
         std::shared_ptr<IExtensionDialog> dlg(reinterpret_cast<IExtensionDialog*>(lib->Dialog()));
         std::shared_ptr<Metadata_> m(lib->Meta());
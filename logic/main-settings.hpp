@@ -41,6 +41,8 @@ struct OTR_LOGIC_EXPORT module_settings
     value<QString> tracker_dll { b, "tracker-dll", "pt" };
     value<QString> filter_dll { b, "filter-dll", "accela" };
     value<QString> protocol_dll { b, "protocol-dll", "freetrack" };
+    // additional outputs fed alongside protocol-dll, each on its own thread
+    value<QList<QString>> extra_protocol_dlls { b, "extra-protocol-dlls", {} };
     module_settings();
 };
 
@@ -96,6 +98,13 @@ struct OTR_LOGIC_EXPORT main_settings final
     key_opts key_zero_press1 { b, "zero-press" };
     key_opts key_zero_press2 { b, "zero-press-alt" };
 
+    // needs CAP_SYS_NICE or an RLIMIT_RTPRIO on Linux, see rt_thread::apply()
+    value<bool> rt_enable { b, "realtime-scheduling", false };
+    value<int> rt_priority { b, "realtime-priority", 10 };
+    value<int> rt_pipeline_cpu { b, "realtime-pipeline-cpu", -1 };
+    value<int> rt_capture_cpu { b, "realtime-capture-cpu", -1 };
+    value<bool> rt_lock_memory { b, "realtime-lock-memory", false };
+
     value<bool> tracklogging_enabled { b, "tracklogging-enabled", false };
     value<QString> tracklogging_filename { b, "tracklogging-filename", {} };
 
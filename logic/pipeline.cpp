@@ -16,6 +16,7 @@
 #include "compat/math.hpp"
 #include "compat/meta.hpp"
 #include "compat/macros.hpp"
+#include "compat/rt-thread.hpp"
 
 #include "pipeline.hpp"
 #include "logic/shortcuts.h"
@@ -23,6 +24,7 @@
 #include <cmath>
 #include <algorithm>
 #include <cstdio>
+#include <cstdint>
 
 #ifdef _WIN32
 #   include <windows.h>
@@ -40,6 +42,18 @@ void reltrans::on_center()
     moving_to_reltans = false;
 }
 
+const rmat& reltrans::rotation_for(const euler_t& angles)
+{
+    if (!last_R_valid || angles(0) != last_angles(0) || angles(1) != last_angles(1) || angles(2) != last_angles(2))
+    {
+        last_R = euler_to_rmat(angles);
+        last_angles = angles;
+        last_R_valid = true;
+    }
+
+    return last_R;
+}
+
 euler_t reltrans::rotate(const rmat& R, const euler_t& in, vec3_bool disable) const
 {
     enum { tb_Z, tb_X, tb_Y };
@@ -98,7 +112,7 @@ Pose reltrans::apply_pipeline(reltrans_state state, const Pose& value,
         {
             constexpr double d2r = M_PI / 180;
 
-            const rmat R = euler_to_rmat(
+            const rmat& R = rotation_for(
                                euler_t(value(Yaw)   * d2r * !disable(Yaw),
                                        value(Pitch) * d2r * !disable(Pitch),
                                        value(Roll)  * d2r * !disable(Roll)));
@@ -179,7 +193,7 @@ euler_t reltrans::apply_neck(const rmat& R, int nz, bool disable_tz) const
 }
 
 pipeline::pipeline(Mappings& m, runtime_libraries& libs, event_handler& ev, TrackLogger& logger) :
-    m(m), ev(ev), libs(libs), logger(logger)
+    m(m), ev(ev), libs(libs), protocols(libs), logger(logger)
 {
 }
 
@@ -296,6 +310,10 @@ Pose pipeline::clamp_value(Pose value) const
     // hatire, udp, and freepie trackers can mess up here
     for (unsigned i = 3; i < 6; i++)
     {
+        // the usual case, fmod() below is a no-op then
+        if (std::fabs(value(i)) <= 180)
+            continue;
+
         value(i) = std::fmod(value(i), 360);
 
         const double x = value(i);
@@ -385,11 +403,22 @@ Pose pipeline::apply_reltrans(Pose value, vec6_bool disabled, bool centerp)
     return value;
 }
 
+std::uint64_t pipeline::lap()
+{
+    const Timer::time_type ret = lap_timer.elapsed_nsecs();
+    lap_timer.start();
+    return (std::uint64_t)std::max<Timer::time_type>(0, ret);
+}
+
 void pipeline::logic()
 {
     using namespace euler;
     using EV = event_handler::event_ordinal;
 
+    lap_timer.start();
+    // the mapping stage is split in two by reltrans
+    std::uint64_t rotation_ns = 0;
+
     logger.write_dt();
     logger.reset_dt();
 
@@ -401,7 +430,9 @@ void pipeline::logic()
     {
         Pose tmp;
         libs.pTracker->data(tmp);
+        timings.record(stage::tracker, lap());
         ev.run_events(EV::ev_raw, tmp);
+        timings.record(stage::ev_raw, lap());
         newpose = tmp;
     }
 
@@ -421,8 +452,11 @@ void pipeline::logic()
         logger.write_pose(value);
     }
 
+    timings.record(stage::center, lap());
+
     {
         ev.run_events(EV::ev_before_filter, value);
+        timings.record(stage::ev_before_filter, lap());
         // we must proceed with all the filtering since the filter
         // needs fresh values to prevent deconvergence
         if (center_ordered)
@@ -433,14 +467,19 @@ void pipeline::logic()
         logger.write_pose(value); // "filtered"
     }
 
+    timings.record(stage::filter, lap());
+
     {
         ev.run_events(EV::ev_before_mapping, value);
+        timings.record(stage::ev_before_mapping, lap());
         // CAVEAT rotation only, due to reltrans
         for (int i = 3; i < 6; i++)
             value(i) = map(value(i), m(i));
     }
 
+    rotation_ns = lap();
     value = apply_reltrans(value, disabled, center_ordered);
+    timings.record(stage::reltrans, lap());
 
     {
         // CAVEAT translation only, due to tcomp
@@ -449,6 +488,8 @@ void pipeline::logic()
         nan_check(value);
     }
 
+    timings.record(stage::mapping, rotation_ns + lap());
+
     if (!hold_ordered)
         goto ok;
 
@@ -474,8 +515,13 @@ ok:
 
     value = apply_zero_pos(value);
 
+    // don't charge the hold/error path to the next stage
+    lap_timer.start();
+
     ev.run_events(EV::ev_finished, value);
-    libs.pProtocol->pose(value);
+    timings.record(stage::ev_finished, lap());
+    protocols.pose(value);
+    timings.record(stage::protocol, lap());
 
     QMutexLocker foo(&mtx);
     output_pose = value;
@@ -485,6 +531,7 @@ ok:
 
     logger.reset_dt();
     logger.next_line();
+    timings.record(stage::logger, lap());
 }
 
 void pipeline::run()
@@ -495,6 +542,8 @@ void pipeline::run()
 
     setPriority(QThread::HighPriority);
     setPriority(QThread::HighestPriority);
+    // after setPriority(), which would otherwise rescale it
+    (void)rt_thread::apply(rt_thread::pipeline, "pipeline");
 
     {
         static const char* const posechannels[6] = { "TX", "TY", "TZ", "Yaw", "Pitch", "Roll" };
@@ -519,7 +568,18 @@ void pipeline::run()
 
     while (!isInterruptionRequested())
     {
-        logic();
+        {
+            Timer tick;
+            logic();
+            const Timer::time_type tick_ns = tick.elapsed_nsecs();
+            const double tick_ms = tick_ns * 1e-6;
+            timings.record(stage::total, (std::uint64_t)std::max<Timer::time_type>(0, tick_ns));
+
+            QMutexLocker l(&mtx);
+            stat_ticks++;
+            stat_sum_ms += tick_ms;
+            stat_max_ms = std::fmax(stat_max_ms, tick_ms);
+        }
 
         constexpr ns const_sleep_ms(ms{4});
         const ns elapsed_nsecs = t.elapsed<ns>();
@@ -561,7 +621,7 @@ void pipeline::run()
 
     // filter may inhibit exact origin
     Pose p;
-    libs.pProtocol->pose(p);
+    protocols.stop(p);
 
     for (int i = 0; i < 6; i++)
     {
@@ -586,6 +646,22 @@ void pipeline::raw_and_mapped_pose(double* mapped, double* raw) const
     }
 }
 
+tick_stats pipeline::get_tick_stats()
+{
+    QMutexLocker l(&mtx);
+
+    tick_stats ret;
+    ret.ticks = stat_ticks;
+    ret.mean_ms = stat_ticks ? stat_sum_ms / stat_ticks : 0;
+    ret.max_ms = stat_max_ms;
+
+    stat_ticks = 0;
+    stat_sum_ms = 0;
+    stat_max_ms = 0;
+
+    return ret;
+}
+
 void pipeline::set_center(bool x) { b.set(f_center, x); }
 
 void pipeline::set_held_center(bool value)
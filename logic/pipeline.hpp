@@ -8,6 +8,8 @@
 #include "compat/euler.hpp"
 #include "compat/enum-operators.hpp"
 #include "runtime-libraries.hpp"
+#include "protocol-fanout.hpp"
+#include "stage-timings.hpp"
 #include "extensions.hpp"
 
 #include "spline/spline.hpp"
@@ -44,6 +46,13 @@ class reltrans
     bool moving_to_reltans = false;
     bool in_zone = false;
 
+    // filters hold their output still most of the time, don't redo the trig then
+    euler_t last_angles;
+    rmat last_R;
+    bool last_R_valid = false;
+
+    const rmat& rotation_for(const euler_t& angles);
+
 public:
     reltrans();
 
@@ -79,6 +88,12 @@ struct OTR_LOGIC_EXPORT bits
 
 DEFINE_ENUM_OPERATORS(bit_flags);
 
+struct OTR_LOGIC_EXPORT tick_stats final
+{
+    unsigned ticks = 0;
+    double mean_ms = 0, max_ms = 0;
+};
+
 class OTR_LOGIC_EXPORT pipeline : private QThread
 {
     Q_OBJECT
@@ -93,6 +108,7 @@ class OTR_LOGIC_EXPORT pipeline : private QThread
 
     Pose newpose;
     runtime_libraries const& libs;
+    protocol_fanout protocols;
     // The owner of the reference is the main window.
     // This design might be useful if we decide later on to swap out
     // the logger while the tracker is running.
@@ -106,6 +122,16 @@ class OTR_LOGIC_EXPORT pipeline : private QThread
 
     bool tracking_started = false;
 
+    // written by the pipeline thread only, read without locking
+    stage_timings timings;
+    Timer lap_timer;
+    // time since the previous call
+    std::uint64_t lap();
+
+    // guarded by mtx, reset by get_tick_stats()
+    unsigned stat_ticks = 0;
+    double stat_sum_ms = 0, stat_max_ms = 0;
+
     double map(double pos, Map& axis);
     void logic();
     void run() override;
@@ -127,6 +153,12 @@ public:
     ~pipeline() override;
 
     void raw_and_mapped_pose(double* mapped, double* raw) const;
+    // time spent in logic() since the last call
+    tick_stats get_tick_stats();
+    // delivery counters for each output since the last call
+    std::vector<protocol_stats> get_protocol_stats() { return protocols.get_stats(); }
+    // cumulative since start, subtract an older snapshot for an interval
+    stage_timings::snapshot_t get_stage_timings() const { return timings.snapshot(); }
     void start() { QThread::start(QThread::HighPriority); }
 
     void toggle_zero();
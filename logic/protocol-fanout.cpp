@@ -0,0 +1,261 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "protocol-fanout.hpp"
+
+#include "compat/math.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+namespace pipeline_impl {
+
+resampler_settings::resampler_settings(const QString& module_name) :
+    opts("protocol-output-" + module_name)
+{}
+
+protocol_worker::protocol_worker(const QString& name, std::shared_ptr<IProtocol> proto,
+                                 int rate_hz, int extrapolate_ms) :
+    rate_hz(clamp(rate_hz, 0, 2000)),
+    extrapolate_ms(clamp(extrapolate_ms, 0, 100)),
+    name(name), proto(std::move(proto))
+{
+    start(QThread::HighPriority);
+}
+
+protocol_worker::~protocol_worker()
+{
+    stop();
+}
+
+void protocol_worker::post(const double* value)
+{
+    slot& s = slots[write_idx];
+    std::copy(value, value + 6, s.pose);
+    s.since_posted.start();
+
+    const unsigned old = middle.exchange(write_idx | fresh_bit, std::memory_order_acq_rel);
+    write_idx = old & idx_mask;
+
+    if (rate_hz > 0)
+        // resampling skips most ticks by design, they aren't drops
+        return;
+
+    if (old & fresh_bit)
+        // worker hasn't picked up the previous one and won't now
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    else
+        sem.release();
+}
+
+void protocol_worker::stop()
+{
+    if (!isRunning())
+        return;
+
+    requestInterruption();
+    sem.release();
+    wait();
+}
+
+void protocol_worker::run()
+{
+    if (rate_hz > 0)
+        run_resampled();
+    else
+        run_on_post();
+}
+
+void protocol_worker::account(double latency_ms)
+{
+    QMutexLocker l(&stats_mtx);
+    delivered++;
+    sum_ms += latency_ms;
+    max_ms = std::fmax(max_ms, latency_ms);
+}
+
+void protocol_worker::run_on_post()
+{
+    for (;;)
+    {
+        sem.acquire();
+
+        if (isInterruptionRequested())
+            break;
+
+        const unsigned old = middle.exchange(read_idx, std::memory_order_acq_rel);
+        read_idx = old & idx_mask;
+
+        if (!(old & fresh_bit))
+            continue;
+
+        const slot& s = slots[read_idx];
+        proto->pose(s.pose);
+        account(s.since_posted.elapsed_ms());
+    }
+}
+
+void protocol_worker::run_resampled()
+{
+    using clock = std::chrono::steady_clock;
+
+    const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::nanoseconds(1'000'000'000 / rate_hz));
+    clock::time_point deadline = clock::now();
+
+    epoch.start();
+
+    while (!isInterruptionRequested())
+    {
+        deadline += period;
+        std::this_thread::sleep_until(deadline);
+
+        // fell behind, e.g. suspended. don't try to catch up in a burst.
+        if (clock::now() - deadline > period * 4)
+            deadline = clock::now();
+
+        const unsigned old = middle.exchange(read_idx, std::memory_order_acq_rel);
+        read_idx = old & idx_mask;
+
+        const double now = epoch.elapsed_ms();
+
+        if (old & fresh_bit)
+        {
+            const slot& s = slots[read_idx];
+
+            // the pipeline repeats the last pose between tracker frames,
+            // only a pose that changed is a new sample
+            if (hist_count == 0 || !std::equal(s.pose, s.pose + 6, hist[1]))
+            {
+                std::copy(hist[1], hist[1] + 6, hist[0]);
+                hist_time[0] = hist_time[1];
+                std::copy(s.pose, s.pose + 6, hist[1]);
+                hist_time[1] = now - s.since_posted.elapsed_ms();
+                hist_count = std::min(hist_count + 1, 2u);
+            }
+        }
+
+        if (hist_count == 0)
+            continue;
+
+        double out[6];
+        resample(now, out);
+        proto->pose(out);
+        account(now - hist_time[1]);
+    }
+}
+
+void protocol_worker::resample(double now, double* out) const
+{
+    const double dt = hist_time[1] - hist_time[0];
+
+    if (hist_count < 2 || dt <= 0)
+    {
+        std::copy(hist[1], hist[1] + 6, out);
+        return;
+    }
+
+    double alpha;
+
+    if (extrapolate_ms > 0)
+    {
+        const double since = std::fmax(0., now - hist_time[1]);
+        double ahead = std::fmin(since, extrapolate_ms);
+
+        // a new pose was due by now. the input stopped, e.g. in accela's
+        // deadzone, fade back to the last pose over an interval rather
+        // than hold the overshoot.
+        if (since > dt)
+            ahead *= std::fmax(0., 2 - since / dt);
+
+        alpha = 1 + ahead / dt;
+    }
+    else
+        // stay an interval behind so there are always poses on both sides
+        alpha = clamp((now - dt - hist_time[0]) / dt, 0., 1.);
+
+    for (unsigned k = 0; k < 6; k++)
+    {
+        double d = hist[1][k] - hist[0][k];
+
+        // take the short way across +-180
+        if (k >= 3)
+        {
+            if (d > 180)
+                d -= 360;
+            else if (d < -180)
+                d += 360;
+        }
+
+        double x = hist[0][k] + d * alpha;
+
+        if (k >= 3)
+        {
+            if (x > 180)
+                x -= 360;
+            else if (x < -180)
+                x += 360;
+        }
+
+        out[k] = x;
+    }
+}
+
+protocol_stats protocol_worker::get_stats()
+{
+    protocol_stats ret;
+    ret.name = name;
+    ret.dropped = dropped.exchange(0, std::memory_order_relaxed);
+
+    QMutexLocker l(&stats_mtx);
+    ret.delivered = delivered;
+    ret.mean_ms = delivered ? sum_ms / delivered : 0;
+    ret.max_ms = max_ms;
+    delivered = 0; sum_ms = 0; max_ms = 0;
+
+    return ret;
+}
+
+protocol_fanout::protocol_fanout(const runtime_libraries& libs)
+{
+    workers.reserve(libs.protocols.size());
+    for (const auto& p : libs.protocols)
+    {
+        resampler_settings s(p.module);
+        workers.push_back(std::make_unique<protocol_worker>(p.name, p.ptr, *s.rate_hz, *s.extrapolate_ms));
+    }
+}
+
+protocol_fanout::~protocol_fanout() = default;
+
+void protocol_fanout::pose(const double* value)
+{
+    for (auto& w : workers)
+        w->post(value);
+}
+
+void protocol_fanout::stop(const double* value)
+{
+    for (auto& w : workers)
+        w->stop();
+    for (auto& w : workers)
+        w->proto->pose(value);
+}
+
+std::vector<protocol_stats> protocol_fanout::get_stats()
+{
+    std::vector<protocol_stats> ret;
+    ret.reserve(workers.size());
+    for (auto& w : workers)
+        ret.push_back(w->get_stats());
+    return ret;
+}
+
+} // ns pipeline_impl
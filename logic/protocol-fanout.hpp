@@ -0,0 +1,123 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "runtime-libraries.hpp"
+#include "compat/timer.hpp"
+#include "options/options.hpp"
+#include "export.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QString>
+#include <QThread>
+#include <QSemaphore>
+#include <QMutex>
+
+namespace pipeline_impl {
+
+struct OTR_LOGIC_EXPORT protocol_stats final
+{
+    QString name;
+    // dropped poses were replaced by a newer one before the protocol got
+    // to them, never counted when resampling
+    unsigned delivered = 0, dropped = 0;
+    // from handing the pose off to the protocol's pose() returning, or
+    // when resampling, the age of the newest input pose
+    double mean_ms = 0, max_ms = 0;
+};
+
+using namespace options;
+
+// kept per protocol module in "protocol-output-<module>"
+struct OTR_LOGIC_EXPORT resampler_settings final : opts
+{
+    // 0 hands over every pipeline tick as is, otherwise the protocol gets
+    // poses interpolated between the last two at this rate
+    value<int> rate_hz { b, "rate-hz", 0 };
+    // 0 interpolates one input interval behind, otherwise extrapolates
+    // up to this far past the newest pose instead, fading back to it once
+    // no new one came for an interval
+    value<int> extrapolate_ms { b, "extrapolate-ms", 0 };
+
+    explicit resampler_settings(const QString& module_name);
+};
+
+// runs one protocol's pose() on its own thread. the pipeline only ever
+// swaps an index, so a slow protocol can't stretch the tick.
+class protocol_worker final : private QThread
+{
+    struct slot final
+    {
+        double pose[6] {};
+        Timer since_posted;
+    };
+
+    static constexpr unsigned fresh_bit = 4, idx_mask = 3;
+
+    // triple buffer. the producer owns write_idx, the worker owns read_idx,
+    // the third one is exchanged between them along with the fresh bit.
+    std::array<slot, 3> slots;
+    unsigned write_idx = 0, read_idx = 1;
+    std::atomic<unsigned> middle { 2 };
+
+    QSemaphore sem;
+    std::atomic<unsigned> dropped { 0 };
+
+    QMutex stats_mtx;
+    unsigned delivered = 0;
+    double sum_ms = 0, max_ms = 0;
+
+    // resampling, worker thread only
+    const int rate_hz;
+    const double extrapolate_ms;
+    Timer epoch;
+    double hist[2][6] {};
+    double hist_time[2] {};
+    unsigned hist_count = 0;
+
+    void run() override;
+    void run_on_post();
+    void run_resampled();
+    void resample(double now, double* out) const;
+    void account(double latency_ms);
+
+public:
+    const QString name;
+    const std::shared_ptr<IProtocol> proto;
+
+    protocol_worker(const QString& name, std::shared_ptr<IProtocol> proto,
+                    int rate_hz = 0, int extrapolate_ms = 0);
+    ~protocol_worker() override;
+
+    // pipeline thread only, never blocks
+    void post(const double* value);
+    void stop();
+    protocol_stats get_stats();
+};
+
+class OTR_LOGIC_EXPORT protocol_fanout final
+{
+    std::vector<std::unique_ptr<protocol_worker>> workers;
+
+public:
+    explicit protocol_fanout(const runtime_libraries& libs);
+    ~protocol_fanout();
+
+    void pose(const double* value);
+    // joins the workers, then hands `value' to every protocol directly
+    void stop(const double* value);
+    // counters since the last call
+    std::vector<protocol_stats> get_stats();
+};
+
+} // ns pipeline_impl
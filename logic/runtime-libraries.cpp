@@ -1,5 +1,8 @@
 #include "runtime-libraries.hpp"
 #include "options/scoped.hpp"
+
+#include <algorithm>
+
 #include <QMessageBox>
 #include <QDebug>
 
@@ -7,7 +10,8 @@
 #   pragma clang diagnostic ignored "-Wcomma"
 #endif
 
-runtime_libraries::runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f)
+runtime_libraries::runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f,
+                                     const std::vector<dylibptr>& extra_protocols)
 {
     auto error = [](const QString& msg) { return module_status_mixin::error(msg); };
 
@@ -33,6 +37,35 @@ runtime_libraries::runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dyli
         goto end;
     }
 
+    protocols.push_back({ p->name, p->module_name, pProtocol });
+
+    for (const dylibptr& lib : extra_protocols)
+    {
+        if (!lib || lib == p)
+            continue;
+
+        if (std::any_of(protocols.cbegin(), protocols.cend(),
+                        [&](const protocol& x) { return x.name == lib->name; }))
+            continue;
+
+        std::shared_ptr<IProtocol> ptr = make_dylib_instance<IProtocol>(lib);
+
+        if (!ptr)
+        {
+            qDebug() << "protocol dylib load failure" << lib->module_name;
+            goto end;
+        }
+
+        if (status = ptr->initialize(), !status.is_ok())
+        {
+            status = error(tr("Error occurred while loading protocol %1\n\n%2\n")
+                           .arg(lib->name, status.error));
+            goto end;
+        }
+
+        protocols.push_back({ lib->name, lib->module_name, std::move(ptr) });
+    }
+
     pTracker = make_dylib_instance<ITracker>(t);
     pFilter = make_dylib_instance<IFilter>(f);
 
@@ -42,7 +75,7 @@ runtime_libraries::runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dyli
         goto end;
     }
 
-    if (f && f->Constructor && !pFilter)
+    if (f && !f->full_filename.isEmpty() && !pFilter)
     {
         qDebug() << "filter load failure";
         goto end;
@@ -70,10 +103,16 @@ end:
     pTracker = nullptr;
     pFilter = nullptr;
     pProtocol = nullptr;
+    protocols.clear();
+
+    if (status.is_ok())
+        return;
 
-    if (!status.is_ok())
+    if (frame)
         QMessageBox::critical(nullptr,
                               tr("Startup failure"), status.error,
                               QMessageBox::Cancel, QMessageBox::NoButton);
+    else
+        qDebug().noquote() << "startup failure:" << status.error;
 }
 
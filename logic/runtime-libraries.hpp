@@ -12,6 +12,8 @@
 #include "compat/tr.hpp"
 #include "export.hpp"
 
+#include <vector>
+
 class QFrame;
 
 class OTR_LOGIC_EXPORT runtime_libraries final : public TR
@@ -25,7 +27,17 @@ public:
     std::shared_ptr<IFilter> pFilter;
     std::shared_ptr<IProtocol> pProtocol;
 
-    runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f);
+    struct protocol final
+    {
+        QString name, module;
+        std::shared_ptr<IProtocol> ptr;
+    };
+    // pProtocol first, then the extra outputs
+    std::vector<protocol> protocols;
+
+    // a null frame means no preview is wanted and errors aren't shown in a dialog
+    runtime_libraries(QFrame* frame, dylibptr t, dylibptr p, dylibptr f,
+                      const std::vector<dylibptr>& extra_protocols = {});
     runtime_libraries() = default;
 
     bool correct = false;
@@ -0,0 +1,135 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "stage-timings.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace pipeline_impl {
+
+const char* stage_name(stage s)
+{
+    static const char* const names[] = {
+        "tracker", "ev-raw", "center", "ev-before-filter", "filter",
+        "ev-before-mapping", "mapping", "reltrans", "ev-finished",
+        "protocol", "logger", "total",
+    };
+    static_assert(std::size(names) == (unsigned)stage::COUNT);
+
+    return (unsigned)s < (unsigned)stage::COUNT ? names[(unsigned)s] : "<invalid>";
+}
+
+unsigned histogram_snapshot::bucket_for(std::uint64_t ns)
+{
+    if (ns < sub_count)
+        return (unsigned)ns;
+
+    unsigned msb = 0;
+    for (std::uint64_t x = ns; x >>= 1; )
+        msb++;
+
+    const unsigned shift = msb - sub_bits;
+    const unsigned idx = (shift + 1) * sub_count + (unsigned)((ns >> shift) & (sub_count - 1));
+
+    return std::min(idx, bucket_count - 1);
+}
+
+std::uint64_t histogram_snapshot::bucket_lower_bound(unsigned idx)
+{
+    const unsigned e = idx / sub_count, m = idx % sub_count;
+
+    if (e == 0)
+        return m;
+    else
+        return std::uint64_t(sub_count + m) << (e - 1);
+}
+
+double histogram_snapshot::mean_ms() const
+{
+    return n ? sum_ns * 1e-6 / n : 0;
+}
+
+double histogram_snapshot::percentile_ms(double q) const
+{
+    std::uint64_t total = 0;
+    for (std::uint32_t c : counts)
+        total += c;
+
+    if (total == 0)
+        return 0;
+
+    const std::uint64_t rank = std::max<std::uint64_t>(1, (std::uint64_t)std::ceil(q * total));
+    std::uint64_t acc = 0;
+
+    for (unsigned k = 0; k < bucket_count; k++)
+    {
+        acc += counts[k];
+        if (acc >= rank)
+        {
+            const std::uint64_t lo = bucket_lower_bound(k);
+            const std::uint64_t hi = k + 1 < bucket_count ? bucket_lower_bound(k + 1) : lo;
+            return (lo + hi) * .5e-6;
+        }
+    }
+
+    return 0;
+}
+
+double histogram_snapshot::max_ms() const
+{
+    for (unsigned k = bucket_count; k-- > 0; )
+        if (counts[k])
+            return (k + 1 < bucket_count ? bucket_lower_bound(k + 1) : bucket_lower_bound(k)) * 1e-6;
+
+    return 0;
+}
+
+histogram_snapshot histogram_snapshot::operator-(const histogram_snapshot& old) const
+{
+    histogram_snapshot ret;
+
+    for (unsigned k = 0; k < bucket_count; k++)
+        ret.counts[k] = counts[k] - old.counts[k];
+    ret.n = n - old.n;
+    ret.sum_ns = sum_ns - old.sum_ns;
+
+    return ret;
+}
+
+void histogram::record(std::uint64_t ns)
+{
+    // only the pipeline thread writes, so these don't need to be RMW ops
+    auto& c = counts[histogram_snapshot::bucket_for(ns)];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum_ns.store(sum_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+histogram_snapshot histogram::snapshot() const
+{
+    histogram_snapshot ret;
+
+    ret.n = n.load(std::memory_order_acquire);
+    ret.sum_ns = sum_ns.load(std::memory_order_relaxed);
+    for (unsigned k = 0; k < histogram_snapshot::bucket_count; k++)
+        ret.counts[k] = counts[k].load(std::memory_order_relaxed);
+
+    return ret;
+}
+
+stage_timings::snapshot_t stage_timings::snapshot() const
+{
+    snapshot_t ret;
+    for (unsigned k = 0; k < (unsigned)stage::COUNT; k++)
+        ret[k] = hists[k].snapshot();
+    return ret;
+}
+
+} // ns pipeline_impl
@@ -0,0 +1,82 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "export.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace pipeline_impl {
+
+enum class stage : unsigned
+{
+    tracker,
+    ev_raw,
+    center,
+    ev_before_filter,
+    filter,
+    ev_before_mapping,
+    mapping,
+    reltrans,
+    ev_finished,
+    protocol,
+    logger,
+    total,
+    COUNT,
+};
+
+OTR_LOGIC_EXPORT const char* stage_name(stage s);
+
+// log-linear buckets over nanoseconds, 16 per power of two, i.e. within
+// 1/16 of the value up to ~4 seconds. counters only ever grow, readers
+// subtract two snapshots to get an interval.
+struct OTR_LOGIC_EXPORT histogram_snapshot final
+{
+    static constexpr unsigned sub_bits = 4, sub_count = 1 << sub_bits;
+    static constexpr unsigned bucket_count = (32 - sub_bits + 1) * sub_count;
+
+    std::array<std::uint32_t, bucket_count> counts {};
+    std::uint64_t n = 0, sum_ns = 0;
+
+    static unsigned bucket_for(std::uint64_t ns);
+    static std::uint64_t bucket_lower_bound(unsigned idx);
+
+    double mean_ms() const;
+    // q in [0, 1]
+    double percentile_ms(double q) const;
+    double max_ms() const;
+
+    histogram_snapshot operator-(const histogram_snapshot& old) const;
+};
+
+// single writer, any number of readers, no locks
+class OTR_LOGIC_EXPORT histogram final
+{
+    std::array<std::atomic<std::uint32_t>, histogram_snapshot::bucket_count> counts {};
+    std::atomic<std::uint64_t> n { 0 }, sum_ns { 0 };
+
+public:
+    void record(std::uint64_t ns);
+    histogram_snapshot snapshot() const;
+};
+
+struct OTR_LOGIC_EXPORT stage_timings final
+{
+    using snapshot_t = std::array<histogram_snapshot, (unsigned)stage::COUNT>;
+
+    void record(stage s, std::uint64_t ns) { hists[(unsigned)s].record(ns); }
+    snapshot_t snapshot() const;
+
+private:
+    std::array<histogram, (unsigned)stage::COUNT> hists;
+};
+
+} // ns pipeline_impl
@@ -2,6 +2,8 @@
 
 #include <iterator>
 
+#include <QDebug>
+
 using dylib_ptr = Modules::dylib_ptr;
 using dylib_list = Modules::dylib_list;
 
@@ -43,3 +45,17 @@ dylib_ptr State::current_filter()
     auto [ptr, idx] = module_by_name(m.filter_dll, modules.filters());
     return ptr;
 }
+
+std::vector<dylib_ptr> State::current_extra_protocols()
+{
+    std::vector<dylib_ptr> ret;
+    for (const QString& name : *m.extra_protocol_dlls)
+    {
+        auto [ptr, idx] = module_by_name(name, modules.protocols());
+        if (ptr)
+            ret.push_back(ptr);
+        else
+            qDebug() << "no such protocol" << name;
+    }
+    return ret;
+}
@@ -17,6 +17,7 @@
 #include "export.hpp"
 
 #include <memory>
+#include <vector>
 #include <QString>
 
 struct OTR_LOGIC_EXPORT State
@@ -30,6 +31,7 @@ struct OTR_LOGIC_EXPORT State
     dylib_ptr current_tracker();
     dylib_ptr current_protocol();
     dylib_ptr current_filter();
+    std::vector<dylib_ptr> current_extra_protocols();
 
     Modules modules;
     event_handler ev;
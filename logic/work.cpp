@@ -1,11 +1,14 @@
 #include "work.hpp"
 #include "compat/library-path.hpp"
+#include "compat/rt-thread.hpp"
 
+#include <algorithm>
 #include <utility>
 
 #include <QObject>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QDebug>
 
 QString Work::browse_datalogging_file(main_settings &s)
 {
@@ -31,12 +34,12 @@ QString Work::browse_datalogging_file(main_settings &s)
     return newfilename;
 }
 
-std::unique_ptr<TrackLogger> Work::make_logger(main_settings &s)
+std::unique_ptr<TrackLogger> Work::make_logger(main_settings &s, bool headless)
 {
     if (s.tracklogging_enabled)
     {
-        QString filename = browse_datalogging_file(s);
-        if (filename.isEmpty())
+        QString filename = headless ? *s.tracklogging_filename : browse_datalogging_file(s);
+        if (filename.isEmpty() && !headless)
         {
             // The user probably canceled the file dialog. In this case we don't want to do anything.
             return {};
@@ -45,7 +48,9 @@ std::unique_ptr<TrackLogger> Work::make_logger(main_settings &s)
         {
             auto logger = std::make_unique<TrackLoggerCSV>(*s.tracklogging_filename);
 
-            if (!logger->is_open())
+            if (!logger->is_open() && headless)
+                qDebug() << "unable to open tracklogger file" << filename;
+            else if (!logger->is_open())
             {
                 QMessageBox::warning(nullptr,
                     tr("Logging error"),
@@ -61,14 +66,34 @@ std::unique_ptr<TrackLogger> Work::make_logger(main_settings &s)
 }
 
 
+Work::apply_rt_config::apply_rt_config(const main_settings& s)
+{
+    rt_thread::config c;
+    c.realtime = s.rt_enable;
+    c.priority = s.rt_priority;
+    c.lock_memory = s.rt_lock_memory;
+
+    c.cpu = s.rt_pipeline_cpu;
+    rt_thread::set_config(rt_thread::pipeline, c);
+
+    // capture threads do the heavy lifting, keep them a notch below
+    c.priority = std::max(1, *s.rt_priority - 1);
+    c.cpu = s.rt_capture_cpu;
+    rt_thread::set_config(rt_thread::capture, c);
+}
+
 Work::Work(Mappings& m, event_handler& ev, QFrame* frame,
-           const dylibptr& tracker_, const dylibptr& filter_, const dylibptr& proto_) :
-    libs(frame, tracker_, filter_, proto_),
+           const dylibptr& tracker_, const dylibptr& filter_, const dylibptr& proto_,
+           const std::vector<dylibptr>& extra_protos) :
+    libs(frame, tracker_, filter_, proto_, extra_protos),
+    logger{ make_logger(s, frame == nullptr) },
     pipeline_{ m, libs, ev, *logger }
 {
     if (!is_ok())
         return;
-    reload_shortcuts();
+    // no display to grab global hotkeys from when headless
+    if (frame)
+        reload_shortcuts();
     pipeline_.start();
 }
 
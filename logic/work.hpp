@@ -31,15 +31,22 @@ class OTR_LOGIC_EXPORT Work final : public TR
 
     using dylibptr = std::shared_ptr<dylib>;
 
-    static std::unique_ptr<TrackLogger> make_logger(main_settings &s);
+    static std::unique_ptr<TrackLogger> make_logger(main_settings &s, bool headless);
     static QString browse_datalogging_file(main_settings &s);
 
+    // hands the realtime settings to rt_thread on construction
+    struct apply_rt_config final
+    {
+        explicit apply_rt_config(const main_settings& s);
+    };
+
 public:
     using fn_t = std::function<void(bool)>;
     using key_tuple = std::tuple<key_opts&, fn_t, bool>;
     main_settings s; // pipeline needs settings, so settings must come before it
+    apply_rt_config rt_config { s }; // trackers start their threads in libs' ctor
     runtime_libraries libs; // idem
-    std::unique_ptr<TrackLogger> logger { make_logger(s) }; // must come before pipeline, since pipeline depends on it
+    std::unique_ptr<TrackLogger> logger; // must come before pipeline, since pipeline depends on it
     pipeline pipeline_;
     Shortcuts sc;
 
@@ -59,8 +66,10 @@ public:
         key_tuple(s.key_zero_press2, [&](bool x) { pipeline_.set_zero(x); }, false),
     };
 
+    // frame may be null for headless operation, see runtime_libraries
     Work(Mappings& m, event_handler& ev, QFrame* frame,
-         const dylibptr& tracker, const dylibptr& filter, const dylibptr& proto);
+         const dylibptr& tracker, const dylibptr& filter, const dylibptr& proto,
+         const std::vector<dylibptr>& extra_protos = {});
     void reload_shortcuts();
     bool is_ok() const;
 };
@@ -59,7 +59,7 @@ static bool mk_dialog(std::unique_ptr<t>& place, const std::shared_ptr<dylib>& l
     using u = std::unique_ptr<t>;
 
     return mk_window_common(place, [&] {
-        if (lib && lib->Dialog)
+        if (lib && lib->load())
             return u{ (t*)lib->Dialog() };
         else
             return u{};
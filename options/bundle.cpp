@@ -11,6 +11,7 @@
 #include "globals.hpp"
 
 #include <cstdlib>
+#include <algorithm>
 
 #include <QThread>
 #include <QCoreApplication>
@@ -36,30 +37,48 @@ void bundle::reload_no_notify()
 
     QMutexLocker l{&mtx};
 
-    saved = group(group_name);
+    group next(group_name);
+
+    for (const auto& [k, v] : next.kvs)
+    {
+        auto it = transient.kvs.find(k);
+        if (it == transient.kvs.cend() || it->second != v)
+            stale.push_back(k);
+    }
+    for (const auto& kv : transient.kvs)
+        if (!next.contains(kv.first))
+            stale.push_back(kv.first);
+
+    saved = std::move(next);
     transient = saved;
 }
 
 void bundle::notify()
 {
+    bool changedp;
+
     {
         QMutexLocker l(&mtx);
-        connector::notify_all_values();
+
+        std::sort(stale.begin(), stale.end());
+        stale.erase(std::unique(stale.begin(), stale.end()), stale.end());
+
+        changedp = !stale.empty();
+
+        for (const QString& name : stale)
+            connector::notify_values(name);
+        stale.clear();
     }
 
     emit reloading();
-    emit changed();
+    if (changedp)
+        emit changed();
 }
 
 void bundle::reload()
 {
-    {
-        QMutexLocker l{&mtx};
-        reload_no_notify();
-        connector::notify_all_values();
-    }
-    emit reloading();
-    emit changed();
+    reload_no_notify();
+    notify();
 }
 
 void bundle::set_all_to_default()
@@ -104,8 +123,9 @@ void bundle::save()
 
     {
         QMutexLocker l{&mtx};
+        if (!transient.save_changes(saved))
+            return;
         saved = transient;
-        saved.save();
     }
 
     emit saving();
@@ -146,8 +166,8 @@ void bundler::notify_()
 void bundler::reload_()
 {
     QMutexLocker l(&implsgl_mtx);
-    notify_();
     reload_no_notify_();
+    notify_();
 }
 
 void bundler::notify() { singleton().notify_(); }
@@ -51,6 +51,8 @@ class OTR_OPTIONS_EXPORT bundle final : public QObject, public connector
     const QString group_name;
     group saved;
     group transient;
+    // keys that changed in reload_no_notify() and haven't been notified yet
+    std::vector<QString> stale;
 
     void reload_no_notify();
 
@@ -73,6 +75,7 @@ public:
     bool contains(const QString& name) const;
 
     QVariant get_variant(const QString& name) const;
+    // notifies values whose keys changed since the last reload
     void notify();
 
 public slots:
@@ -1,6 +1,7 @@
 #include "globals.hpp"
 #include "compat/base-path.hpp"
 #include "defs.hpp"
+#include "writer.hpp"
 
 #include <QFile>
 #include <QDir>
@@ -112,8 +113,27 @@ QString ini_filename()
     });
 }
 
+static QString& forced_ini_pathname()
+{
+    static QString ret;
+    return ret;
+}
+
+void force_ini_pathname(const QString& pathname)
+{
+    forced_ini_pathname() = pathname;
+}
+
+void flush_pending_saves()
+{
+    options::detail::writer::instance().flush();
+}
+
 QString ini_pathname()
 {
+    if (const QString& forced = forced_ini_pathname(); !forced.isEmpty())
+        return forced;
+
     const auto dir = ini_directory();
     if (dir.isEmpty())
         return {};
@@ -56,6 +56,10 @@ namespace options::globals
     OTR_OPTIONS_EXPORT QString ini_pathname();
     OTR_OPTIONS_EXPORT QString ini_combine(const QString& filename);
     OTR_OPTIONS_EXPORT QStringList ini_list();
+    // use this .ini instead of the profile selected in global settings
+    OTR_OPTIONS_EXPORT void force_ini_pathname(const QString& pathname);
+    // bundle saves are written in the background, wait for them to finish
+    OTR_OPTIONS_EXPORT void flush_pending_saves();
 
     template<typename F>
     auto with_settings_object(F&& fun)
@@ -9,6 +9,7 @@
 #include "group.hpp"
 #include "defs.hpp"
 #include "globals.hpp"
+#include "writer.hpp"
 
 #include <utility>
 #include <algorithm>
@@ -34,6 +35,10 @@ group::group(const QString& name) : name(name)
         for (auto const& k : conf.childKeys())
             kvs[k] = conf.value(k);
         conf.endGroup();
+
+        // saves that haven't reached the file yet
+        if (conf.format() == QSettings::IniFormat)
+            writer::instance().overlay(conf.fileName(), name, kvs);
     });
 }
 
@@ -50,6 +55,40 @@ void group::save() const
     });
 }
 
+bool group::save_changes(const group& old) const
+{
+    if (name.isEmpty())
+        return false;
+
+    std::unordered_map<QString, QVariant> changes;
+
+    for (auto const& [k, v] : kvs)
+    {
+        auto it = old.kvs.find(k);
+        if (it == old.kvs.cend() || it->second != v)
+            changes[k] = v;
+    }
+
+    if (changes.empty())
+        return false;
+
+    with_settings_object([&](QSettings& s) {
+        if (s.format() == QSettings::IniFormat)
+            writer::instance().put(s.fileName(), name, std::move(changes));
+        else
+        {
+            // registry and such, write through
+            s.beginGroup(name);
+            for (auto const& [k, v] : changes)
+                s.setValue(k, v);
+            s.endGroup();
+            mark_ini_modified();
+        }
+    });
+
+    return true;
+}
+
 void group::put(const QString& s, const QVariant& d)
 {
     if (d.isNull())
@@ -28,6 +28,8 @@ namespace options::detail {
         std::unordered_map<QString, QVariant> kvs;
         explicit group(const QString& name);
         void save() const;
+        // only writes keys whose values differ from `old'. returns false if there were none.
+        bool save_changes(const group& old) const;
         void put(const QString& s, const QVariant& d);
         bool contains(const QString& s) const;
 
@@ -0,0 +1,157 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#include "writer.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include <QSettings>
+#include <QDebug>
+
+namespace options::detail {
+
+writer::writer() = default;
+
+writer::~writer()
+{
+    {
+        QMutexLocker l(&mtx);
+        quit = true;
+        wake.wakeAll();
+    }
+
+    if (isRunning())
+        wait();
+    else
+        // thread never started or already gone
+        write(pending);
+}
+
+writer& writer::instance()
+{
+    static writer ret;
+    return ret;
+}
+
+void writer::put(const QString& pathname, const QString& group, kvs&& changes)
+{
+    if (changes.empty())
+        return;
+
+    QMutexLocker l(&mtx);
+
+    if (pending.empty())
+        since_first.start();
+    since_last.start();
+
+    kvs& dest = pending[pathname][group];
+    for (auto& [k, v] : changes)
+        dest[k] = std::move(v);
+
+    if (!isRunning() && !quit)
+        start(QThread::LowPriority);
+
+    wake.wakeOne();
+}
+
+void writer::overlay(const QString& pathname, const QString& group, kvs& out) const
+{
+    QMutexLocker l(&mtx);
+
+    // inflight first, pending is newer
+    for (const files* f : { &inflight, &pending })
+    {
+        const auto it = f->find(pathname);
+        if (it == f->cend())
+            continue;
+        const auto it2 = it->second.find(group);
+        if (it2 == it->second.cend())
+            continue;
+        for (const auto& [k, v] : it2->second)
+            out[k] = v;
+    }
+}
+
+void writer::flush()
+{
+    QMutexLocker l(&mtx);
+
+    if (!isRunning())
+    {
+        write(pending);
+        pending.clear();
+        return;
+    }
+
+    flushp = true;
+    wake.wakeOne();
+
+    while (!pending.empty() || !inflight.empty())
+        idle.wait(&mtx);
+}
+
+void writer::run()
+{
+    QMutexLocker l(&mtx);
+
+    for (;;)
+    {
+        while (pending.empty() && !quit)
+            wake.wait(&mtx);
+
+        if (pending.empty())
+            break;
+
+        // wait for a burst of saves to settle, but not forever
+        while (!quit && !flushp)
+        {
+            const double quiet = since_last.elapsed_ms(), age = since_first.elapsed_ms();
+            if (quiet >= debounce_ms || age >= max_delay_ms)
+                break;
+            (void)wake.wait(&mtx, (unsigned long)std::min(debounce_ms - quiet, max_delay_ms - age) + 1);
+        }
+
+        flushp = false;
+        inflight = std::move(pending);
+        pending.clear();
+
+        l.unlock();
+        write(inflight);
+        l.relock();
+
+        inflight.clear();
+        idle.wakeAll();
+    }
+}
+
+void writer::write(const files& data)
+{
+    for (const auto& [pathname, groups] : data)
+    {
+        // QSettings shares its cache between instances on the same file,
+        // and writes the .ini through QSaveFile, i.e. to a temporary then
+        // renamed over the old one
+        QSettings s(pathname, QSettings::IniFormat);
+
+        for (const auto& [group, kvs] : groups)
+        {
+            s.beginGroup(group);
+            for (const auto& [k, v] : kvs)
+                s.setValue(k, v);
+            s.endGroup();
+        }
+
+        s.sync();
+
+        if (s.status() != QSettings::NoError)
+            qDebug() << "error with .ini file" << pathname << s.status();
+    }
+}
+
+} // ns options::detail
@@ -0,0 +1,58 @@
+/* Copyright (c) 2019, Stanislaw Halik <sthalik@misaki.pl>
+
+ * Permission to use, copy, modify, and/or distribute this
+ * software for any purpose with or without fee is hereby granted,
+ * provided that the above copyright notice and this permission
+ * notice appear in all copies.
+ */
+
+#pragma once
+
+#include "compat/timer.hpp"
+#include "compat/qhash.hpp"
+#include "export.hpp"
+
+#include <unordered_map>
+
+#include <QString>
+#include <QVariant>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace options::detail {
+
+// batches bundle saves and writes them to the .ini file on its own thread
+// once they stop coming in. until then readers see them through overlay().
+class OTR_OPTIONS_EXPORT writer final : QThread
+{
+    using kvs = std::unordered_map<QString, QVariant>;
+    using groups = std::unordered_map<QString, kvs>;
+    using files = std::unordered_map<QString, groups>;
+
+    static constexpr unsigned debounce_ms = 250, max_delay_ms = 2000;
+
+    mutable QMutex mtx;
+    QWaitCondition wake, idle;
+
+    // pending is still being batched, inflight is being written right now
+    files pending, inflight;
+    Timer since_first, since_last;
+    bool quit = false, flushp = false;
+
+    void run() override;
+    static void write(const files& data);
+
+    writer();
+    ~writer() override;
+
+public:
+    static writer& instance();
+
+    void put(const QString& pathname, const QString& group, kvs&& changes);
+    void overlay(const QString& pathname, const QString& group, kvs& out) const;
+    // blocks until everything put() so far is on disk
+    void flush();
+};
+
+} // ns options::detail
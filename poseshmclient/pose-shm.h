@@ -0,0 +1,62 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+/* Shared memory layout of the pose publisher, Linux only.
+ *
+ * opentrack writes every pose into the next slot of a ring, readers keep
+ * their own position in it and don't write anything except `waiting'.
+ * Waiting is a futex on `futex', bumped after every pose. Readers set
+ * `waiting' before every wait, the publisher clears it and only then
+ * makes the wakeup syscall. A reader killed while blocked costs one
+ * wakeup, not one for every pose after it.
+ *
+ * Each slot's `seq' is zero while it's being written, then the pose's
+ * sequence number. A reader copies the slot and checks that `seq' didn't
+ * change meanwhile, a slow reader can't hold up the publisher.
+ *
+ * Fields are accessed with the __atomic builtins so that C and C++ share
+ * the same plain struct. */
+
+#include <stdint.h>
+
+#define POSE_SHM_NAME "opentrack-pose-shm"
+#define POSE_SHM_MAGIC 0x6f747073u /* "otps" */
+#define POSE_SHM_VERSION 1u
+#define POSE_SHM_RING_SIZE 64u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pose_shm_sample
+{
+    uint64_t seq;
+    /* CLOCK_MONOTONIC when published */
+    uint64_t time_ns;
+    /* x, y, z in centimeters, then yaw, pitch, roll in degrees */
+    double data[6];
+};
+
+struct pose_shm
+{
+    uint32_t magic, version;
+    uint32_t ring_size, sample_size;
+    /* the publisher's pid, zero after it stopped */
+    uint32_t pid;
+    uint32_t futex;
+    uint32_t waiting;
+    uint32_t pad;
+    /* the last complete sample's seq, zero before the first one */
+    uint64_t head;
+    struct pose_shm_sample ring[POSE_SHM_RING_SIZE];
+};
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
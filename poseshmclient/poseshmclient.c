@@ -0,0 +1,209 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#ifndef _GNU_SOURCE
+#   define _GNU_SOURCE
+#endif
+
+#include "poseshmclient.h"
+#include "compat/linkage-macros.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+struct pose_shm_client
+{
+    struct pose_shm* shm;
+    /* seq of the last pose read */
+    uint64_t last;
+};
+
+static int layout_matches(const struct pose_shm* shm)
+{
+    return __atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) == POSE_SHM_MAGIC &&
+           shm->version == POSE_SHM_VERSION &&
+           shm->ring_size == POSE_SHM_RING_SIZE &&
+           shm->sample_size == sizeof(struct pose_shm_sample);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* zero if the slot was overwritten, or is being written */
+static int read_slot(const struct pose_shm* shm, uint64_t seq, struct pose_shm_pose* pose)
+{
+    const struct pose_shm_sample* s = &shm->ring[seq % POSE_SHM_RING_SIZE];
+    unsigned k;
+
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != seq)
+        return 0;
+
+    pose->seq = seq;
+    pose->time_ns = __atomic_load_n(&s->time_ns, __ATOMIC_RELAXED);
+    for (k = 0; k < 6; k++)
+        __atomic_load(&s->data[k], &pose->data[k], __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq;
+}
+
+OTR_GENERIC_EXPORT
+struct pose_shm_client* pose_shm_open(void)
+{
+    struct pose_shm_client* c;
+    struct stat st;
+    void* mem;
+    int fd = shm_open("/" POSE_SHM_NAME, O_RDWR, 0);
+
+    if (fd == -1)
+        return NULL;
+
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(struct pose_shm))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    mem = mmap(NULL, sizeof(struct pose_shm), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mem == MAP_FAILED)
+        return NULL;
+
+    if (!layout_matches(mem) || !(c = calloc(1, sizeof(*c))))
+    {
+        munmap(mem, sizeof(struct pose_shm));
+        return NULL;
+    }
+
+    c->shm = mem;
+    c->last = __atomic_load_n(&c->shm->head, __ATOMIC_ACQUIRE);
+
+    return c;
+}
+
+OTR_GENERIC_EXPORT
+void pose_shm_close(struct pose_shm_client* c)
+{
+    if (!c)
+        return;
+
+    munmap(c->shm, sizeof(struct pose_shm));
+    free(c);
+}
+
+OTR_GENERIC_EXPORT
+int pose_shm_wait(struct pose_shm_client* c, int timeout_ms)
+{
+    struct pose_shm* shm = c->shm;
+    const uint64_t deadline = now_ns() + (uint64_t)(timeout_ms < 0 ? 0 : timeout_ms) * 1000000u;
+
+    for (;;)
+    {
+        struct timespec ts;
+        uint32_t futex;
+        int ret = -2;
+
+        /* the publisher bumps `futex' after `head', then clears `waiting'.
+         * either it sees us waiting and wakes us up, or the futex no
+         * longer has the value we wait on and the wait returns at once. */
+        __atomic_store_n(&shm->waiting, 1u, __ATOMIC_SEQ_CST);
+        futex = __atomic_load_n(&shm->futex, __ATOMIC_SEQ_CST);
+
+        if (__atomic_load_n(&shm->head, __ATOMIC_SEQ_CST) != c->last)
+            ret = 1;
+        else if (__atomic_load_n(&shm->pid, __ATOMIC_SEQ_CST) == 0)
+            ret = -1;
+        else
+        {
+            const uint64_t now = now_ns();
+
+            if (timeout_ms >= 0 && now >= deadline)
+                ret = 0;
+            else
+            {
+                if (timeout_ms >= 0)
+                {
+                    ts.tv_sec = (time_t)((deadline - now) / 1000000000u);
+                    ts.tv_nsec = (long)((deadline - now) % 1000000000u);
+                }
+
+                /* not FUTEX_PRIVATE, it's shared with another process */
+                (void)syscall(SYS_futex, &shm->futex, FUTEX_WAIT, futex,
+                              timeout_ms >= 0 ? &ts : NULL, NULL, 0);
+            }
+        }
+
+        if (ret != -2)
+            return ret;
+    }
+}
+
+OTR_GENERIC_EXPORT
+int pose_shm_read_next(struct pose_shm_client* c, struct pose_shm_pose* pose)
+{
+    const struct pose_shm* shm = c->shm;
+    uint64_t head = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE);
+    uint64_t seq = c->last + 1;
+
+    for (;;)
+    {
+        if (head == 0 || head == c->last)
+            return 0;
+
+        /* fell behind by more than the ring, keep a slot of margin for
+         * the one being written */
+        if (head >= POSE_SHM_RING_SIZE && seq < head - POSE_SHM_RING_SIZE + 2)
+            seq = head - POSE_SHM_RING_SIZE + 2;
+        /* the publisher started over */
+        if (seq > head)
+            seq = head;
+
+        if (read_slot(shm, seq, pose))
+        {
+            c->last = seq;
+            return 1;
+        }
+
+        head = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE);
+        seq++;
+    }
+}
+
+OTR_GENERIC_EXPORT
+int pose_shm_read_latest(struct pose_shm_client* c, struct pose_shm_pose* pose)
+{
+    const struct pose_shm* shm = c->shm;
+
+    for (;;)
+    {
+        const uint64_t head = __atomic_load_n(&shm->head, __ATOMIC_ACQUIRE);
+
+        if (head == 0)
+            return -1;
+
+        if (read_slot(shm, head, pose))
+        {
+            const int ret = head != c->last;
+            c->last = head;
+            return ret;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+/* Client for opentrack's "Pose shared memory" output.
+ *
+ *     struct pose_shm_client* c = pose_shm_open();
+ *     struct pose_shm_pose pose;
+ *
+ *     while (c && pose_shm_wait(c, 1000) >= 0)
+ *         while (pose_shm_read_next(c, &pose) > 0)
+ *             use(&pose);
+ *
+ * Reading is lock-free and makes no syscalls, only waiting does. Any
+ * number of clients can read at the same time. */
+
+#include "pose-shm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct pose_shm_client;
+
+struct pose_shm_pose
+{
+    /* increments by one for every pose published */
+    uint64_t seq;
+    /* CLOCK_MONOTONIC in nanoseconds */
+    uint64_t time_ns;
+    /* x, y, z in centimeters, then yaw, pitch, roll in degrees */
+    double data[6];
+};
+
+/* NULL if opentrack never ran the output since boot. the client then
+ * starts at the newest pose. */
+struct pose_shm_client* pose_shm_open(void);
+void pose_shm_close(struct pose_shm_client* c);
+
+/* blocks until there's a pose the client hasn't read. returns 1 for a
+ * new pose, 0 on timeout, -1 once opentrack stopped the output.
+ * a negative timeout waits forever. */
+int pose_shm_wait(struct pose_shm_client* c, int timeout_ms);
+
+/* the oldest pose not read yet, in order. returns 1 if there was one,
+ * otherwise 0. when the client fell behind by more than the ring, poses
+ * get skipped, see the seq. */
+int pose_shm_read_next(struct pose_shm_client* c, struct pose_shm_pose* pose);
+
+/* the newest pose, skipping the unread ones. returns 1 if it's one the
+ * client hasn't read before, 0 if it's the same as last time, -1 if no
+ * pose was published yet. */
+int pose_shm_read_latest(struct pose_shm_client* c, struct pose_shm_pose* pose);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
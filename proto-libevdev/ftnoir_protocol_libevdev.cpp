@@ -12,6 +12,7 @@
 #include <string.h>
 
 #include <algorithm>
+#include <iterator>
 
 #define CHECK_LIBEVDEV(expr) if ((error = (expr)) != 0) goto error;
 
@@ -23,6 +24,8 @@ evdev::evdev() : dev(NULL), uidev(NULL)
 {
     int error = 0;
 
+    std::fill(std::begin(last_value), std::end(last_value), -1);
+
     dev = libevdev_new();
 
     if (!dev)
@@ -82,23 +85,62 @@ void evdev::pose(const double* headpose) {
         ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ
     };
 
-    static const int max_value[] = {
-        100,
-        100,
-        100,
-        180,
-        90,
-        180
+    if (!uidev)
+        return;
+
+    const int max_value[] = {
+        s.range_x,
+        s.range_y,
+        s.range_z,
+        s.range_yaw,
+        s.range_pitch,
+        s.range_roll,
     };
 
+    // the whole report in a single write(), the kernel takes any number
+    // of events at once and stamps them itself
+    struct input_event events[7] {};
+    int indices[6];
+    unsigned nevents = 0;
+
     for (int i = 0; i < 6; i++)
     {
-        int value = headpose[i] * mid_input / max_value[i] + mid_input;
+        int value = headpose[i] * mid_input / std::max(1, max_value[i]) + mid_input;
         int normalized = clamp(value, min_input, max_input);
-        (void) libevdev_uinput_write_event(uidev, EV_ABS, axes[i], normalized);
+
+        if (normalized == last_value[i])
+            continue;
+
+        indices[nevents] = i;
+        struct input_event& ev = events[nevents++];
+        ev.type = EV_ABS;
+        ev.code = axes[i];
+        ev.value = normalized;
     }
 
-    (void) libevdev_uinput_write_event(uidev, EV_SYN, SYN_REPORT, 0);
+    if (nevents == 0)
+        return;
+
+    const unsigned naxes = nevents;
+
+    struct input_event& ev = events[nevents++];
+    ev.type = EV_SYN;
+    ev.code = SYN_REPORT;
+    ev.value = 0;
+
+    const ssize_t size = (ssize_t)(nevents * sizeof(*events));
+
+    if (write(libevdev_uinput_get_fd(uidev), events, (size_t)size) == size)
+    {
+        for (unsigned k = 0; k < naxes; k++)
+            last_value[indices[k]] = events[k].value;
+    }
+    else
+    {
+        // some of them may have gone through, send them all next time
+        for (unsigned k = 0; k < naxes; k++)
+            last_value[indices[k]] = -1;
+    }
 }
 
 module_status evdev::initialize()
@@ -9,11 +9,28 @@
 
 #include "compat/macros.hpp"
 #include "api/plugin-api.hpp"
+#include "options/options.hpp"
+using namespace options;
 #include <libevdev/libevdev.h>
 #include <libevdev/libevdev-uinput.h>
 
 #include <QMessageBox>
 
+// the pose at which each axis reaches the end of its range, in
+// centimeters and degrees
+struct settings : opts {
+    value<int> range_x, range_y, range_z, range_yaw, range_pitch, range_roll;
+    settings() :
+        opts("libevdev-proto"),
+        range_x(b, "range-x", 100),
+        range_y(b, "range-y", 100),
+        range_z(b, "range-z", 100),
+        range_yaw(b, "range-yaw", 180),
+        range_pitch(b, "range-pitch", 90),
+        range_roll(b, "range-roll", 180)
+    {}
+};
+
 class evdev : public TR, public IProtocol
 {
     Q_OBJECT
@@ -26,8 +43,11 @@ public:
     module_status initialize() override;
 
 private:
+    settings s;
     struct libevdev* dev;
     struct libevdev_uinput* uidev;
+    // after quantization, only axes that changed get written
+    int last_value[6];
 };
 
 class LibevdevControls: public IProtocolDialog
@@ -41,6 +61,7 @@ public:
 
 private:
     Ui::UICLibevdevControls ui;
+    settings s;
     void save();
 
 private slots:
@@ -6,6 +6,13 @@ LibevdevControls::LibevdevControls()
 	ui.setupUi( this );
 	connect(ui.btnOK, SIGNAL(clicked()), this, SLOT(doOK()));
 	connect(ui.btnCancel, SIGNAL(clicked()), this, SLOT(doCancel()));
+
+	tie_setting(s.range_x, ui.range_x);
+	tie_setting(s.range_y, ui.range_y);
+	tie_setting(s.range_z, ui.range_z);
+	tie_setting(s.range_yaw, ui.range_yaw);
+	tie_setting(s.range_pitch, ui.range_pitch);
+	tie_setting(s.range_roll, ui.range_roll);
 }
 
 void LibevdevControls::doOK() {
@@ -18,4 +25,5 @@ void LibevdevControls::doCancel() {
 }
 
 void LibevdevControls::save() {
+    s.b->save();
 }
@@ -0,0 +1,29 @@
+<?xml version="1.0" encoding="utf-8"?>
+<!DOCTYPE TS>
+<TS version="2.1">
+<context>
+    <name>pose_shm_dialog</name>
+    <message>
+        <source>Poses are published to shared memory &quot;/%1&quot;, with a wakeup for every one of them. Programs read them using the poseshmclient library.</source>
+        <translation type="unfinished"></translation>
+    </message>
+</context>
+<context>
+    <name>pose_shm_metadata</name>
+    <message>
+        <source>Pose shared memory</source>
+        <translation type="unfinished"></translation>
+    </message>
+</context>
+<context>
+    <name>pose_shm_proto</name>
+    <message>
+        <source>Native programs</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <source>Can&apos;t map shared memory &quot;/%1&quot;</source>
+        <translation type="unfinished"></translation>
+    </message>
+</context>
+</TS>
@@ -0,0 +1,28 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "pose-shm-proto.h"
+
+#include <QDialogButtonBox>
+#include <QLabel>
+#include <QVBoxLayout>
+
+pose_shm_dialog::pose_shm_dialog()
+{
+    setLayout(new QVBoxLayout);
+
+    auto label = new QLabel(tr("Poses are published to shared memory \"/%1\", with a wakeup "
+                               "for every one of them. Programs read them using the "
+                               "poseshmclient library.").arg(POSE_SHM_NAME));
+    label->setWordWrap(true);
+    layout()->addWidget(label);
+
+    layout()->addItem(new QSpacerItem(0, 0, QSizePolicy::Ignored, QSizePolicy::Expanding));
+    auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok);
+    layout()->addWidget(buttonBox);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+}
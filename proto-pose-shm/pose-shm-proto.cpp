@@ -0,0 +1,87 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "pose-shm-proto.h"
+
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+pose_shm_proto::pose_shm_proto() = default;
+
+pose_shm_proto::~pose_shm_proto()
+{
+    if (!shm)
+        return;
+
+    // waiting clients return, new ones see there's nothing to wait for
+    __atomic_store_n(&shm->pid, 0u, __ATOMIC_SEQ_CST);
+    wake();
+}
+
+module_status pose_shm_proto::initialize()
+{
+    if (!mem.success())
+        return error(tr("Can't map shared memory \"/%1\"").arg(POSE_SHM_NAME));
+
+    shm = (pose_shm*)mem.ptr();
+
+    // clients that stayed open across restarts keep reading in sequence,
+    // a different layout starts over
+    if (shm->magic != POSE_SHM_MAGIC || shm->version != POSE_SHM_VERSION ||
+        shm->ring_size != POSE_SHM_RING_SIZE || shm->sample_size != sizeof(pose_shm_sample))
+    {
+        std::memset(shm, 0, sizeof(*shm));
+        shm->version = POSE_SHM_VERSION;
+        shm->ring_size = POSE_SHM_RING_SIZE;
+        shm->sample_size = sizeof(pose_shm_sample);
+        __atomic_store_n(&shm->magic, POSE_SHM_MAGIC, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&shm->pid, (uint32_t)getpid(), __ATOMIC_SEQ_CST);
+
+    return status_ok();
+}
+
+void pose_shm_proto::pose(const double* headpose)
+{
+    timespec ts {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    const uint64_t seq = shm->head + 1;
+    pose_shm_sample& s = shm->ring[seq % POSE_SHM_RING_SIZE];
+
+    // seqlock, readers discard the slot unless its seq stays the same
+    // over their copy of it
+    __atomic_store_n(&s.seq, 0u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&s.time_ns, uint64_t(ts.tv_sec) * 1000000000u + uint64_t(ts.tv_nsec), __ATOMIC_RELAXED);
+    for (unsigned k = 0; k < 6; k++)
+        __atomic_store(&s.data[k], &headpose[k], __ATOMIC_RELAXED);
+
+    __atomic_store_n(&s.seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->head, seq, __ATOMIC_SEQ_CST);
+
+    wake();
+}
+
+void pose_shm_proto::wake()
+{
+    __atomic_add_fetch(&shm->futex, 1u, __ATOMIC_SEQ_CST);
+
+    // the syscall only when some client's blocked. clients set it again
+    // before every wait, one that died waiting costs a single wakeup.
+    if (__atomic_exchange_n(&shm->waiting, 0u, __ATOMIC_SEQ_CST) != 0)
+        (void)syscall(SYS_futex, &shm->futex, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+OPENTRACK_DECLARE_PROTOCOL(pose_shm_proto, pose_shm_dialog, pose_shm_metadata)
@@ -0,0 +1,52 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// Publishes poses to shared memory for native programs on the same
+// machine, see poseshmclient/ for the layout and the client.
+
+#include "api/plugin-api.hpp"
+#include "compat/shm.h"
+#include "poseshmclient/pose-shm.h"
+
+class pose_shm_proto : TR, public IProtocol
+{
+    Q_OBJECT
+
+public:
+    pose_shm_proto();
+    ~pose_shm_proto() override;
+
+    module_status initialize() override;
+    void pose(const double* headpose) override;
+    QString game_name() override { return tr("Native programs"); }
+
+private:
+    void wake();
+
+    shm_wrapper mem { POSE_SHM_NAME, nullptr, sizeof(pose_shm) };
+    pose_shm* shm = nullptr;
+};
+
+class pose_shm_dialog : public IProtocolDialog
+{
+    Q_OBJECT
+
+public:
+    pose_shm_dialog();
+    void register_protocol(IProtocol*) override {}
+    void unregister_protocol() override {}
+};
+
+class pose_shm_metadata : public Metadata
+{
+    Q_OBJECT
+
+    QString name() override { return tr("Pose shared memory"); }
+    QIcon icon() override { return QIcon(":/images/linux.png"); }
+};
@@ -4,6 +4,7 @@
 #include <QCoreApplication>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 #include <sys/mman.h>
 #include <sys/stat.h>        /* For mode constants */
 #include <fcntl.h>           /* For O_* constants */
@@ -36,6 +37,9 @@ void wine::pose( const double *headpose )
             shm->data[i] = (headpose[i] * M_PI) / 180;
         for (int i = 0; i < 3; i++)
             shm->data[i] = headpose[i] * 10;
+
+        if (ring)
+            write_sample();
 #ifndef OTR_WINE_NO_WRAPPER
         if (shm->gameid != gameid)
         {
@@ -52,6 +56,26 @@ void wine::pose( const double *headpose )
     }
 }
 
+void wine::write_sample()
+{
+    timespec ts {};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    // initialize() zeroes the ring, only this writes to it after that
+    const std::uint64_t seq = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) + 1;
+    WineSHM_sample& s = ring->samples[seq % WINE_SHM_SAMPLES];
+
+    __atomic_store_n(&s.seq, 0u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&s.time_ns, std::uint64_t(ts.tv_sec) * 1000000000u + std::uint64_t(ts.tv_nsec), __ATOMIC_RELAXED);
+    for (int i = 0; i < 6; i++)
+        __atomic_store(&s.data[i], &shm->data[i], __ATOMIC_RELAXED);
+
+    __atomic_store_n(&s.seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->head, seq, __ATOMIC_RELEASE);
+}
+
 module_status wine::initialize()
 {
 #ifndef OTR_WINE_NO_WRAPPER
@@ -66,6 +90,13 @@ module_status wine::initialize()
         memset(shm, 0, sizeof(*shm));
     }
 
+    // without it, the plugin takes the lock and reads WineSHM instead
+    if (ring_shm.success())
+    {
+        ring = (WineSHM_ring*) ring_shm.ptr();
+        memset(ring, 0, sizeof(*ring));
+    }
+
     if (lck_shm.success())
         return status_ok();
     else
@@ -33,8 +33,12 @@ public:
 #endif
     }
 private:
+    void write_sample();
+
     shm_wrapper lck_shm { WINE_SHM_NAME, WINE_MTX_NAME, sizeof(WineSHM) };
     WineSHM* shm = nullptr;
+    shm_wrapper ring_shm { WINE_RING_NAME, nullptr, sizeof(WineSHM_ring) };
+    WineSHM_ring* ring = nullptr;
 
 #ifndef OTR_WINE_NO_WRAPPER
     QProcess wrapper;
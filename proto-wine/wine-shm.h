@@ -2,10 +2,12 @@
 
 #define WINE_SHM_NAME "facetracknoir-wine-shm"
 #define WINE_MTX_NAME "facetracknoir-wine-mtx"
+#define WINE_RING_NAME "facetracknoir-wine-ring"
 
 // OSX sdk 10.8 build error otherwise
 #undef _LIBCPP_MSVCRT
 
+#include <cstdint>
 #include <memory>
 
 template<typename t> using ptr = std::shared_ptr<t>;
@@ -16,3 +18,25 @@ struct WineSHM {
     unsigned char table[8];
     bool stop;
 };
+
+// a ring of timestamped poses for readers that don't take the lock, the
+// X-Plane plugin. the slot's seq is zero while it's being written, readers
+// check it's the same before and after copying. it's a mapping of its own,
+// older plugins truncate WineSHM's to their size of it.
+#define WINE_SHM_SAMPLES 4
+
+struct WineSHM_sample {
+    alignas(8) std::uint64_t seq;
+    // CLOCK_MONOTONIC
+    std::uint64_t time_ns;
+    double data[6];
+};
+
+struct WineSHM_ring {
+    // seq of the newest complete sample
+    alignas(8) std::uint64_t head;
+    WineSHM_sample samples[WINE_SHM_SAMPLES];
+};
+
+// x-plane-plugin/plugin.c has its own copy
+static_assert(sizeof(WineSHM_ring) == 264, "WineSHM_ring layout changed");
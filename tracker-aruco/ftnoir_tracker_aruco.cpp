@@ -10,6 +10,7 @@
 #include "compat/camera-names.hpp"
 #include "compat/sleep.hpp"
 #include "compat/math-imports.hpp"
+#include "compat/rt-thread.hpp"
 
 #ifdef _MSC_VER
 #   pragma warning(disable : 4702)
@@ -75,11 +76,19 @@ aruco_tracker::~aruco_tracker()
     wait();
     // fast start/stop causes breakage
     portable::sleep(1000);
+    recorder = nullptr;
     camera.release();
 }
 
 module_status aruco_tracker::start_tracker(QFrame* videoframe)
 {
+    if (!videoframe)
+    {
+        // headless, skip drawing the preview
+        start();
+        return status_ok();
+    }
+
     videoframe->show();
     videoWidget = std::make_unique<cv_video_widget>(videoframe);
     layout = std::make_unique<QHBoxLayout>();
@@ -164,6 +173,14 @@ bool aruco_tracker::open_camera()
     resolution_tuple res = resolution_choices[rint];
     int fps = enum_to_fps(s.force_fps);
 
+    if (!s.replay_frames->isEmpty())
+    {
+        replaying = replay.open(s.replay_frames);
+        replay_idx = 0;
+        replay_timer.start();
+        return replaying;
+    }
+
     QMutexLocker l(&camera_mtx);
 
     camera = cv::VideoCapture(camera_name_to_index(s.camera_name));
@@ -180,6 +197,62 @@ bool aruco_tracker::open_camera()
         qDebug() << "aruco tracker: can't open camera";
         return false;
     }
+
+    if (!s.record_frames->isEmpty())
+    {
+        recorder = std::make_unique<frame_recording::recorder>(s.record_frames);
+        if (!recorder->is_open())
+            recorder = nullptr;
+    }
+
+    return true;
+}
+
+bool aruco_tracker::read_replay()
+{
+    if (replay_idx >= replay.size())
+    {
+        replay_idx = 0;
+        replay_timer.start();
+    }
+
+    if (s.replay_realtime)
+    {
+        const double due = (replay.timestamp_ns(replay_idx) - replay.timestamp_ns(0)) * 1e-6;
+        const double now = replay_timer.elapsed_ms();
+
+        if (due > now)
+            portable::sleep(iround(due - now));
+    }
+
+    if (!replay.read(replay_idx++, replay_gray))
+        return false;
+
+    grayscale = replay_gray;
+
+    // the detector only needs the grayscale frame, color is for the preview
+    cv::cvtColor(grayscale, color, cv::COLOR_GRAY2BGR);
+
+    return true;
+}
+
+bool aruco_tracker::read_frame()
+{
+    if (replaying)
+        return read_replay();
+
+    {
+        QMutexLocker l(&camera_mtx);
+
+        if (!camera.read(color))
+            return false;
+    }
+
+    if (recorder)
+        recorder->push(color);
+
+    cv::cvtColor(color, grayscale, cv::COLOR_BGR2GRAY);
+
     return true;
 }
 
@@ -359,8 +432,50 @@ void aruco_tracker::cycle_detection_params()
              << "size:" << adaptive_sizes[adaptive_size_pos];
 }
 
+void aruco_tracker::lens_calibration_step()
+{
+    QMutexLocker l(&lens_calib_mtx);
+
+    // finding the chessboard is slow, a few views a second are plenty
+    if (!lens_calib || lens_calib_timer.elapsed_ms() < 250)
+        return;
+
+    lens_calib_timer.start();
+
+    if (lens_calib->add_view(grayscale))
+        qDebug() << "aruco: lens calibration view" << lens_calib->view_count();
+}
+
+void aruco_tracker::start_lens_calibration()
+{
+    QMutexLocker l(&lens_calib_mtx);
+    lens_calib = std::make_unique<lens_distortion::calibrator>();
+    lens_calib_timer.start();
+}
+
+unsigned aruco_tracker::lens_calibration_views()
+{
+    QMutexLocker l(&lens_calib_mtx);
+    return lens_calib ? lens_calib->view_count() : 0;
+}
+
+bool aruco_tracker::stop_lens_calibration(lens_distortion::model& m, double& rms)
+{
+    QMutexLocker l(&lens_calib_mtx);
+
+    if (!lens_calib)
+        return false;
+
+    const bool ret = lens_calib->calibrate(m, rms);
+    lens_calib = nullptr;
+
+    return ret;
+}
+
 void aruco_tracker::run()
 {
+    (void)rt_thread::apply(rt_thread::capture, "aruco");
+
     if (!open_camera())
         return;
 
@@ -369,18 +484,12 @@ void aruco_tracker::run()
 
     while (!isInterruptionRequested())
     {
+        if (!read_frame())
         {
-            QMutexLocker l(&camera_mtx);
-
-            if (!camera.read(color))
-            {
-                portable::sleep(100);
-                continue;
-            }
+            portable::sleep(100);
+            continue;
         }
 
-        cv::cvtColor(color, grayscale, cv::COLOR_BGR2GRAY);
-
 #ifdef DEBUG_UNSHARP_MASKING
         {
             constexpr double strength = double(DEBUG_UNSHARP_MASKING);
@@ -391,7 +500,12 @@ void aruco_tracker::run()
         }
 #endif
 
-        color.copyTo(frame);
+        lens_calibration_step();
+
+        const bool preview = videoWidget != nullptr;
+
+        if (preview)
+            color.copyTo(frame);
 
         set_intrinsics();
 
@@ -405,7 +519,13 @@ void aruco_tracker::run()
         {
             set_points();
 
-            if (!cv::solvePnP(obj_points, markers[0], intrinsics, cv::noArray(), rvec, tvec, false, cv::SOLVEPNP_ITERATIVE))
+            // the search region and preview are drawn without distortion,
+            // the search window's margin is more than it moves them
+            corners.assign(markers[0].begin(), markers[0].end());
+            undistort.update(s.camera_name, grayscale.cols, grayscale.rows, s.fov);
+            undistort.undistort(corners.data(), (unsigned)corners.size());
+
+            if (!cv::solvePnP(obj_points, corners, intrinsics, cv::noArray(), rvec, tvec, false, cv::SOLVEPNP_ITERATIVE))
                 goto fail;
 
             {
@@ -416,7 +536,8 @@ void aruco_tracker::run()
             }
 
             set_last_roi();
-            draw_centroid();
+            if (preview)
+                draw_centroid();
             set_rmat();
         }
         else
@@ -435,10 +556,13 @@ fail:
             }
         }
 
-        draw_ar(ok);
+        if (preview)
+        {
+            draw_ar(ok);
 
-        if (frame.rows > 0)
-            videoWidget->update_image(frame);
+            if (frame.rows > 0)
+                videoWidget->update_image(frame);
+        }
     }
 }
 
@@ -511,12 +635,27 @@ aruco_dialog::aruco_dialog() :
     connect(this, SIGNAL(destroyed()), this, SLOT(cleanupCalib()));
     connect(&calib_timer, SIGNAL(timeout()), this, SLOT(update_tracker_calibration()));
     connect(ui.camera_settings, SIGNAL(clicked()), this, SLOT(camera_settings()));
+    connect(ui.lens_calib_button, &QPushButton::toggled, this, &aruco_dialog::startstop_lens_calib);
+    connect(ui.lens_reset_button, &QPushButton::clicked, this, &aruco_dialog::reset_lens_calib);
 
     connect(&s.camera_name, value_::value_changed<QString>(), this, &aruco_dialog::update_camera_settings_state);
 
     update_camera_settings_state(s.camera_name);
 }
 
+void aruco_dialog::register_tracker(ITracker* x)
+{
+    tracker = static_cast<aruco_tracker*>(x);
+    ui.lens_calib_button->setEnabled(true);
+}
+
+void aruco_dialog::unregister_tracker()
+{
+    ui.lens_calib_button->setChecked(false);
+    tracker = nullptr;
+    ui.lens_calib_button->setEnabled(false);
+}
+
 void aruco_dialog::toggleCalibrate()
 {
     if (!calib_timer.isActive())
@@ -584,6 +723,71 @@ void aruco_dialog::update_camera_settings_state(const QString& name)
     ui.camera_settings->setEnabled(true);
 }
 
+void aruco_dialog::startstop_lens_calib(bool start)
+{
+    if (start)
+    {
+        if (!tracker)
+            return;
+
+        qDebug() << "aruco: starting lens calibration";
+        tracker->start_lens_calibration();
+        ui.lens_calib_button->setText(tr("Stop lens calibration"));
+        ui.lens_calib_status->setText(tr("Show the chessboard at different positions and angles, covering the whole frame."));
+        return;
+    }
+
+    ui.lens_calib_button->setText(tr("Calibrate lens"));
+
+    if (!tracker)
+    {
+        ui.lens_calib_status->setText(QString());
+        return;
+    }
+
+    const unsigned nviews = tracker->lens_calibration_views();
+    lens_distortion::model m;
+    double rms = 0;
+    int w = 0, h = 0;
+
+    {
+        QMutexLocker l(&tracker->camera_mtx);
+        if (tracker->camera.isOpened())
+        {
+            w = (int)tracker->camera.get(cv::CAP_PROP_FRAME_WIDTH);
+            h = (int)tracker->camera.get(cv::CAP_PROP_FRAME_HEIGHT);
+        }
+    }
+
+    if (tracker->stop_lens_calibration(m, rms))
+    {
+        lens_distortion::store(s.camera_name, m);
+
+        qDebug() << "aruco: lens calibrated, views" << nviews << "rms" << rms;
+
+        QString text = tr("Calibrated from %1 views, error %2 pixels.").arg(nviews).arg(rms, 0, 'f', 2);
+
+        // the corners are now undistorted into the model's field of view
+        if (m.fits(w, h))
+        {
+            const int fov = iround(m.fov(w, h));
+            s.fov = fov;
+            text += ' ' + tr("Field of view set to %1.").arg(fov);
+        }
+
+        ui.lens_calib_status->setText(text);
+    }
+    else
+        ui.lens_calib_status->setText(tr("%1 views, at least %2 are needed. Nothing changed.")
+                                      .arg(nviews).arg(lens_distortion::calibrator::min_views));
+}
+
+void aruco_dialog::reset_lens_calib()
+{
+    lens_distortion::forget(s.camera_name);
+    ui.lens_calib_status->setText(tr("Lens calibration for this camera removed."));
+}
+
 settings::settings() : opts("aruco-tracker") {}
 
 OPENTRACK_DECLARE_TRACKER(aruco_tracker, aruco_dialog, aruco_metadata)
@@ -12,6 +12,8 @@
 #include "cv/translation-calibrator.hpp"
 #include "api/plugin-api.hpp"
 #include "cv/video-widget.hpp"
+#include "cv/frame-recording.hpp"
+#include "cv/lens-distortion.hpp"
 #include "compat/timer.hpp"
 
 #include "aruco/markerdetector.h"
@@ -61,6 +63,12 @@ struct settings : opts {
     value<int> fov { b, "field-of-view", 56 };
     value<aruco_fps> force_fps { b, "force-fps", fps_default };
 
+    // same as tracker-pt's: raw frames are written to record_frames, a
+    // non-empty replay_frames is looped instead of opening the camera
+    value<QString> record_frames { b, "record-frames", "" },
+                   replay_frames { b, "replay-frames", "" };
+    value<bool> replay_realtime { b, "replay-realtime", true };
+
     settings();
 };
 
@@ -76,6 +84,12 @@ public:
     void run() override;
 
     void getRT(cv::Matx33d &r, cv::Vec3d &t);
+
+    // same as tracker-pt's, chessboard views are collected until stopped
+    void start_lens_calibration();
+    unsigned lens_calibration_views();
+    [[nodiscard]] bool stop_lens_calibration(lens_distortion::model& m, double& rms);
+
     QMutex camera_mtx;
     cv::VideoCapture camera;
 
@@ -83,6 +97,8 @@ private:
     bool detect_with_roi();
     bool detect_without_roi();
     bool open_camera();
+    bool read_frame();
+    bool read_replay();
     void set_intrinsics();
     void update_fps();
     void draw_ar(bool ok);
@@ -94,6 +110,7 @@ private:
     void set_roi_from_projection();
     void set_detector_params();
     void cycle_detection_params();
+    void lens_calibration_step();
 
     QMutex mtx;
     std::unique_ptr<cv_video_widget> videoWidget;
@@ -113,9 +130,20 @@ private:
     std::vector<cv::Point3f> obj_points {4};
     aruco::MarkerDetector detector;
     std::vector<aruco::Marker> markers;
+    std::vector<cv::Point2f> corners;
+    lens_distortion::undistorter undistort;
+    QMutex lens_calib_mtx;
+    std::unique_ptr<lens_distortion::calibrator> lens_calib;
+    Timer lens_calib_timer;
     cv::Mat frame, grayscale, color;
     cv::Rect last_roi { 65535, 65535, 0, 0 };
     Timer fps_timer, last_detection_timer;
+    std::unique_ptr<frame_recording::recorder> recorder;
+    frame_recording::replay replay;
+    bool replaying = false;
+    unsigned replay_idx = 0;
+    cv::Mat1b replay_gray;
+    Timer replay_timer;
     unsigned adaptive_size_pos { 0 };
     bool use_otsu = false;
 
@@ -144,8 +172,8 @@ class aruco_dialog : public ITrackerDialog
     Q_OBJECT
 public:
     aruco_dialog();
-    void register_tracker(ITracker * x) override { tracker = static_cast<aruco_tracker*>(x); }
-    void unregister_tracker() override { tracker = nullptr; }
+    void register_tracker(ITracker * x) override;
+    void unregister_tracker() override;
 private:
     void make_fps_combobox();
 
@@ -162,6 +190,8 @@ private Q_SLOTS:
     void update_tracker_calibration();
     void camera_settings();
     void update_camera_settings_state(const QString& name);
+    void startstop_lens_calib(bool start);
+    void reset_lens_calib();
 };
 
 class aruco_metadata : public Metadata
@@ -10,6 +10,10 @@
 
 #include "fusion.h"
 #include "compat/library-path.hpp"
+#include "compat/math-imports.hpp"
+#include "compat/sleep.hpp"
+
+#include <algorithm>
 
 #include <QDebug>
 #include <QMessageBox>
@@ -27,6 +31,8 @@ fusion_tracker::fusion_tracker() = default;
 fusion_tracker::~fusion_tracker()
 {
     // CAVEAT order matters
+    sampler = nullptr;
+
     rot_tracker = nullptr;
     pos_tracker = nullptr;
 
@@ -48,7 +54,6 @@ module_status fusion_tracker::start_tracker(QFrame* frame)
     QString err;
     module_status status;
 
-    fusion_settings s;
     const QString rot_tracker_name = s.rot_tracker_name().toString();
     const QString pos_tracker_name = s.pos_tracker_name().toString();
 
@@ -92,6 +97,12 @@ module_status fusion_tracker::start_tracker(QFrame* frame)
     rot_tracker = make_dylib_instance<ITracker>(rot_dylib);
     pos_tracker = make_dylib_instance<ITracker>(pos_dylib);
 
+    if (!rot_tracker || !pos_tracker)
+    {
+        err = tr("Library load failure");
+        goto end;
+    }
+
     status = pos_tracker->start_tracker(frame);
 
     if (!status.is_ok())
@@ -100,7 +111,7 @@ module_status fusion_tracker::start_tracker(QFrame* frame)
         goto end;
     }
 
-    if (frame->layout() == nullptr)
+    if (!frame || frame->layout() == nullptr)
     {
         status = rot_tracker->start_tracker(frame);
         if (!status.is_ok())
@@ -117,6 +128,9 @@ module_status fusion_tracker::start_tracker(QFrame* frame)
         rot_tracker->start_tracker(other_frame.get());
     }
 
+    if (s.timing != fusion_timing_latest)
+        sampler = std::make_unique<fusion_sampler>(*rot_tracker, *pos_tracker);
+
 end:
     if (!err.isEmpty())
         return error(err);
@@ -128,14 +142,186 @@ void fusion_tracker::data(double *data)
 {
     if (pos_tracker && rot_tracker)
     {
-        rot_tracker->data(rot_tracker_data);
-        pos_tracker->data(pos_tracker_data);
+        if (sampler)
+            sampler->get(s.timing, rot_tracker_data, pos_tracker_data);
+        else
+        {
+            rot_tracker->data(rot_tracker_data);
+            pos_tracker->data(pos_tracker_data);
+        }
 
         for (unsigned k = 0; k < 3; k++)
             data[k] = pos_tracker_data[k];
         for (unsigned k = 3; k < 6; k++)
             data[k] = rot_tracker_data[k];
+
+        if (s.correct_drift)
+            correct_drift(data);
+    }
+}
+
+void fusion_tracker::correct_drift(double* data)
+{
+    // complementary filter. the rotation tracker's own motion goes through
+    // as-is, its offset from the other tracker's rotation follows that one
+    // with the time constant. per axis, fine for the slow drift of an IMU.
+    const double dt = drift_timer.elapsed_seconds();
+    drift_timer.start();
+
+    const double tau = std::fmax(.1, *s.drift_time_constant);
+    const double alpha = drift_first ? 1 : 1 - std::exp(-dt / tau);
+    drift_first = false;
+
+    for (unsigned k = 0; k < 3; k++)
+    {
+        const double err = std::remainder(pos_tracker_data[3+k] - rot_tracker_data[3+k] - drift[k], 360);
+        drift[k] = std::remainder(drift[k] + err * alpha, 360);
+        data[3+k] = std::remainder(rot_tracker_data[3+k] + drift[k], 360);
+    }
+}
+
+static void interpolate(const fusion_source::sample& a, const fusion_source::sample& b, double t, double* data)
+{
+    for (unsigned k = 0; k < 3; k++)
+        data[k] = a.data[k] + (b.data[k] - a.data[k]) * t;
+    // the short way around
+    for (unsigned k = 3; k < 6; k++)
+        data[k] = std::remainder(a.data[k] + std::remainder(b.data[k] - a.data[k], 360) * t, 360);
+}
+
+const fusion_source::sample& fusion_source::nth_newest(unsigned k) const
+{
+    return samples[(head + max_samples - 1 - k) % max_samples];
+}
+
+Timer::time_type fusion_source::last_time() const
+{
+    return count ? nth_newest(0).time : 0;
+}
+
+bool fusion_source::update(const double* data, Timer::time_type now)
+{
+    if (count > 0 && std::equal(data, data + 6, nth_newest(0).data))
+        return false;
+
+    sample& x = samples[head];
+    std::copy(data, data + 6, x.data);
+    x.time = now;
+    head = (head + 1) % max_samples;
+    count = std::min(count + 1, max_samples);
+
+    // median, pauses while the tracker's values hold still don't count
+    Timer::time_type dts[max_samples];
+    const unsigned n = std::min(count - 1, 15u);
+
+    for (unsigned k = 0; k < n; k++)
+        dts[k] = nth_newest(k).time - nth_newest(k+1).time;
+
+    if (n > 0)
+    {
+        std::nth_element(dts, dts + n/2, dts + n);
+        interval_ns = dts[n/2];
+    }
+
+    return true;
+}
+
+void fusion_source::at(Timer::time_type time, bool extrapolate, double* data) const
+{
+    if (count == 0)
+    {
+        std::fill(data, data + 6, 0.);
+        return;
     }
+
+    const sample& last = nth_newest(0);
+
+    if (time >= last.time)
+    {
+        std::copy(last.data, last.data + 6, data);
+
+        if (!extrapolate || count < 2 || interval_ns <= 0)
+            return;
+
+        const sample& prev = nth_newest(1);
+        const Timer::time_type dt = time - last.time;
+        // past an interval the tracker's more likely holding still than
+        // late, fade the prediction back out instead of running off with it
+        const Timer::time_type ahead = dt <= interval_ns ? dt : std::max(Timer::time_type(0), 2 * interval_ns - dt);
+        const Timer::time_type span = std::max(last.time - prev.time, interval_ns);
+
+        interpolate(prev, last, 1 + ahead / (double)span, data);
+        return;
+    }
+
+    for (unsigned k = 1; k < count; k++)
+    {
+        const sample& a = nth_newest(k);
+        const sample& b = nth_newest(k-1);
+
+        if (time >= a.time)
+        {
+            interpolate(a, b, (time - a.time) / (double)(b.time - a.time), data);
+            return;
+        }
+    }
+
+    const sample& first = nth_newest(count - 1);
+    std::copy(first.data, first.data + 6, data);
+}
+
+fusion_sampler::fusion_sampler(ITracker& rot_tracker, ITracker& pos_tracker) :
+    rot_tracker(rot_tracker), pos_tracker(pos_tracker)
+{
+    start(QThread::HighPriority);
+}
+
+fusion_sampler::~fusion_sampler()
+{
+    requestInterruption();
+    wait();
+}
+
+void fusion_sampler::run()
+{
+    // some trackers don't write all of the axes
+    double rot_data[6] {}, pos_data[6] {};
+
+    while (!isInterruptionRequested())
+    {
+        rot_tracker.data(rot_data);
+        pos_tracker.data(pos_data);
+
+        const Timer::time_type now = clock.elapsed_nsecs();
+
+        {
+            QMutexLocker l(&mtx);
+            rot.update(rot_data, now);
+            pos.update(pos_data, now);
+        }
+
+        portable::sleep(1);
+    }
+}
+
+void fusion_sampler::get(fusion_timing timing, double* rot_data, double* pos_data) const
+{
+    Timer::time_type time = clock.elapsed_nsecs();
+    const bool predict = timing == fusion_timing_predict;
+
+    QMutexLocker l(&mtx);
+
+    if (timing == fusion_timing_align)
+    {
+        const fusion_source& slow = rot.interval() >= pos.interval() ? rot : pos;
+        // when the slower one's overdue it's holding still or missed a
+        // sample, either way waiting on it would only add latency
+        if (!slow.empty())
+            time = std::max(slow.last_time(), time - slow.interval());
+    }
+
+    rot.at(time, predict, rot_data);
+    pos.at(time, predict, pos_data);
 }
 
 fusion_dialog::fusion_dialog()
@@ -164,6 +350,14 @@ fusion_dialog::fusion_dialog()
 
     tie_setting(s.rot_tracker_name, ui.rot_tracker);
     tie_setting(s.pos_tracker_name, ui.pos_tracker);
+
+    ui.timing->setItemData(0, int(fusion_timing_latest));
+    ui.timing->setItemData(1, int(fusion_timing_align));
+    ui.timing->setItemData(2, int(fusion_timing_predict));
+
+    tie_setting(s.timing, ui.timing);
+    tie_setting(s.correct_drift, ui.correct_drift);
+    tie_setting(s.drift_time_constant, ui.drift_time_constant);
 }
 
 void fusion_dialog::doOK()
@@ -192,7 +386,10 @@ void fusion_dialog::doCancel()
 fusion_settings::fusion_settings() :
     opts("fusion-tracker"),
     rot_tracker_name(b, "rot-tracker", ""),
-    pos_tracker_name(b, "pos-tracker", "")
+    pos_tracker_name(b, "pos-tracker", ""),
+    timing(b, "timing", fusion_timing_latest),
+    correct_drift(b, "correct-drift", false),
+    drift_time_constant(b, "drift-time-constant", 5)
 {
 }
 
@@ -3,30 +3,109 @@
 #include "api/plugin-api.hpp"
 #include "api/plugin-support.hpp"
 #include "options/options.hpp"
+#include "compat/timer.hpp"
 using namespace options;
 
 #include <memory>
 
 #include <QObject>
 #include <QFrame>
+#include <QMutex>
+#include <QThread>
 #include <QCoreApplication>
 
+enum fusion_timing
+{
+    // whatever each tracker last had, as before
+    fusion_timing_latest = 0,
+    // the faster tracker interpolated to the slower one's last sample
+    fusion_timing_align = 1,
+    // the slower tracker extrapolated to the present
+    fusion_timing_predict = 2,
+};
+
 struct fusion_settings final : opts
 {
     value<QVariant> rot_tracker_name, pos_tracker_name;
+    value<fusion_timing> timing;
+    // pulls the rotation tracker toward the position tracker's own
+    // rotation, for a drifting IMU together with a camera
+    value<bool> correct_drift;
+    value<double> drift_time_constant;
 
     fusion_settings();
 };
 
+// one tracker's recent samples. trackers don't say when their values were
+// measured, a sample's time is when polling first saw it changed.
+class fusion_source final
+{
+public:
+    struct sample final
+    {
+        double data[6] {};
+        Timer::time_type time = 0;
+    };
+
+    static constexpr unsigned max_samples = 64;
+
+    // false if the values are the same as the last sample's
+    bool update(const double* data, Timer::time_type now);
+    bool empty() const { return count == 0; }
+    Timer::time_type last_time() const;
+    // typical time between samples, not counting pauses
+    Timer::time_type interval() const { return interval_ns; }
+    // linear between the samples around `time'. past the last one it's
+    // either held or extrapolated by up to an interval.
+    void at(Timer::time_type time, bool extrapolate, double* data) const;
+
+private:
+    const sample& nth_newest(unsigned k) const;
+
+    sample samples[max_samples];
+    unsigned head = 0, count = 0;
+    Timer::time_type interval_ns = 0;
+};
+
+// polls both trackers much faster than either updates, so that the samples
+// get their times to within a millisecond
+class fusion_sampler final : public QThread
+{
+    ITracker& rot_tracker;
+    ITracker& pos_tracker;
+
+    Timer clock;
+    mutable QMutex mtx;
+    fusion_source rot, pos;
+
+    void run() override;
+
+public:
+    fusion_sampler(ITracker& rot_tracker, ITracker& pos_tracker);
+    ~fusion_sampler() override;
+
+    void get(fusion_timing timing, double* rot_data, double* pos_data) const;
+};
+
 class fusion_tracker : public QObject, public ITracker
 {
     Q_OBJECT
 
+    fusion_settings s;
+
     double rot_tracker_data[6] {}, pos_tracker_data[6] {};
 
+    // rotation tracker's offset from the position tracker's rotation
+    double drift[3] {};
+    Timer drift_timer;
+    bool drift_first = true;
+
+    void correct_drift(double* data);
+
     std::unique_ptr<QFrame> other_frame { std::make_unique<QFrame>() };
     std::shared_ptr<dylib> rot_dylib, pos_dylib;
     std::shared_ptr<ITracker> rot_tracker, pos_tracker;
+    std::unique_ptr<fusion_sampler> sampler;
 
 public:
     fusion_tracker();
@@ -126,6 +126,10 @@ module_status KinectFaceTracker::start_tracker(QFrame* aFrame)
 
 	if (SUCCEEDED(InitializeDefaultSensor()))
 	{
+		// No preview when headless
+		if (!aFrame)
+			return status_ok();
+
 		// Setup our video preview widget
 		iVideoWidget = std::make_unique<video_widget>(aFrame);
 		iLayout = std::make_unique<QHBoxLayout>(aFrame);
@@ -341,7 +345,7 @@ void KinectFaceTracker::Update()
 			ProcessFaces();
 		}
 
-		if (check_is_visible())
+		if (iVideoWidget && check_is_visible())
 		{
 			//OutputDebugStringA("Widget visible!\n");
 			// If our widget is visible we feed it our frame
@@ -0,0 +1,248 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+// Runs PointTracker's capture and blob extraction on a machine next to
+// the camera, sending each frame's blobs to tracker-pt elsewhere, which
+// selects "(remote blobs)" as its camera. Camera and extractor settings
+// are the profile's.
+//
+// Without a second machine, run it next to opentrack as
+//   opentrack-pt-blob-server --host 127.0.0.1 --camera "(synthetic LEDs)"
+
+#include "blob-protocol.hpp"
+#include "camera.h"
+#include "synthetic-camera.hpp"
+#include "replay-camera.hpp"
+#include "frame.hpp"
+#include "point_extractor.h"
+
+#include "options/globals.hpp"
+#include "compat/camera-names.hpp"
+#include "compat/macros.hpp"
+#include "compat/sysexits.hpp"
+#include "compat/timer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QUdpSocket>
+#include <QDebug>
+
+using namespace pt_module;
+
+#ifdef __clang__
+#   pragma GCC diagnostic ignored "-Wmain"
+#endif
+
+static const QString module_name = "tracker-pt";
+
+static std::atomic<bool> quit { false };
+
+static void on_signal(int)
+{
+    quit = true;
+}
+
+static void qdebug_to_stderr(QtMsgType, const QMessageLogContext&, const QString& msg)
+{
+    std::fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    std::fflush(stderr);
+}
+
+static std::unique_ptr<pt_camera> make_camera(const QString& camera_name)
+{
+    if (!pt_settings(module_name).replay_frames->isEmpty())
+        return std::make_unique<replay_camera>(module_name);
+
+    if (camera_name == pt_synthetic_camera_name)
+        return std::make_unique<synthetic_camera>(module_name);
+
+    return std::make_unique<Camera>(module_name);
+}
+
+static QHostAddress resolve(const QString& host)
+{
+    QHostAddress addr;
+
+    if (addr.setAddress(host))
+        return addr;
+
+    for (const QHostAddress& a : QHostInfo::fromName(host).addresses())
+        if (a.protocol() == QAbstractSocket::IPv4Protocol)
+            return a;
+
+    return {};
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    (void)qInstallMessageHandler(qdebug_to_stderr);
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Extract PointTracker blobs from a camera and send them to another machine.");
+    p.addHelpOption();
+
+    QCommandLineOption host_opt("host", "Machine running tracker-pt with the \"(remote blobs)\" camera.", "host");
+    QCommandLineOption port_opt("port", "UDP port it listens on.", "port", QString::number(blob_protocol::default_port));
+    QCommandLineOption profile_opt("profile", "Profile name or path to an .ini file.", "profile");
+    QCommandLineOption camera_opt("camera", "Camera name, instead of the profile's.", "name");
+    QCommandLineOption interval_opt("interval", "Status report interval in milliseconds, 0 for none.", "ms", "5000");
+
+    p.addOptions({ host_opt, port_opt, profile_opt, camera_opt, interval_opt });
+    p.process(app);
+
+    if (!p.isSet(host_opt))
+    {
+        qDebug() << "pt-blob-server: --host is required";
+        return EX_USAGE;
+    }
+
+    const QHostAddress host = resolve(p.value(host_opt));
+    if (host.isNull())
+    {
+        qDebug() << "pt-blob-server: can't resolve" << p.value(host_opt);
+        return EX_NOHOST;
+    }
+
+    bool ok = false;
+    const unsigned port = p.value(port_opt).toUInt(&ok);
+    if (!ok || port == 0 || port > 65535)
+    {
+        qDebug() << "pt-blob-server: bad --port" << p.value(port_opt);
+        return EX_USAGE;
+    }
+
+    const int interval_ms = p.value(interval_opt).toInt(&ok);
+    if (!ok || interval_ms < 0)
+    {
+        qDebug() << "pt-blob-server: bad --interval" << p.value(interval_opt);
+        return EX_USAGE;
+    }
+
+    if (p.isSet(profile_opt))
+    {
+        using namespace options::globals;
+
+        const QString name = p.value(profile_opt);
+        QString path;
+
+        if (name.contains('/') || name.contains('\\'))
+            path = QFileInfo(name).absoluteFilePath();
+        else
+            path = ini_combine(name.endsWith(".ini") ? name : name + ".ini");
+
+        if (!QFileInfo(path).isFile())
+        {
+            qDebug() << "pt-blob-server: no such profile" << path;
+            return EX_NOINPUT;
+        }
+
+        force_ini_pathname(path);
+    }
+
+    pt_settings s(module_name);
+
+    const QString camera_name = p.isSet(camera_opt) ? p.value(camera_opt) : *s.camera_name;
+
+    if (camera_name == pt_remote_camera_name)
+    {
+        qDebug() << "pt-blob-server: the profile's camera is" << camera_name << "-- pass --camera";
+        return EX_CONFIG;
+    }
+
+    std::unique_ptr<pt_camera> camera = make_camera(camera_name);
+    camera->set_fov(s.fov);
+
+    if (!camera->start(camera_name_to_index(camera_name), s.cam_fps, s.cam_res_x, s.cam_res_y))
+    {
+        qDebug() << "pt-blob-server: can't open camera" << camera_name;
+        return EX_UNAVAILABLE;
+    }
+
+    QUdpSocket sock;
+    Frame frame;
+    // the extractor doesn't draw into an empty preview
+    Preview preview(0, 0);
+    PointExtractor extractor(module_name);
+    std::vector<numeric_types::vec2> points;
+
+    blob_protocol::packet pkt {};
+    pkt.h.magic = blob_protocol::magic;
+    pkt.h.version = blob_protocol::version;
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    qDebug() << "pt-blob-server: sending" << camera->get_active_name() << "to"
+             << host.toString() << "port" << port;
+
+    Timer t, report_timer;
+    unsigned frames = 0;
+    double processing_ns = 0;
+
+    while (!quit)
+    {
+        const auto [new_frame, info] = camera->get_frame(frame);
+
+        if (!new_frame)
+            continue;
+
+        // the camera blocks until a frame is ready, so this is close enough
+        // to its capture time
+        const Timer::time_type captured = t.elapsed_nsecs();
+
+        extractor.extract_points(frame, preview, points);
+
+        const std::vector<blob>& blobs = extractor.get_blobs();
+        const unsigned n = std::min((unsigned)blobs.size(), blob_protocol::max_blobs);
+
+        for (unsigned k = 0; k < n; k++)
+        {
+            const blob& b = blobs[k];
+            pkt.blobs[k] = { b.pos[0], b.pos[1], b.radius, b.brightness };
+        }
+
+        pkt.h.count = (std::uint16_t)n;
+        pkt.h.res_x = (std::uint16_t)info.res_x;
+        pkt.h.res_y = (std::uint16_t)info.res_y;
+        pkt.h.fps = info.fps;
+        pkt.h.capture_ns = captured;
+        pkt.h.processing_ns = (std::uint32_t)(t.elapsed_nsecs() - captured);
+
+        if (sock.writeDatagram((const char*)&pkt, pkt.size(), host, (quint16)port) < 0)
+            eval_once(qDebug() << "pt-blob-server: send failed" << sock.errorString());
+
+        pkt.h.seq++;
+        frames++;
+        processing_ns += pkt.h.processing_ns;
+
+        if (interval_ms > 0 && report_timer.elapsed_ms() >= interval_ms)
+        {
+            qDebug().nospace() << "pt-blob-server: " << frames * 1e3 / report_timer.elapsed_ms() << " fps, "
+                               << processing_ns / frames * 1e-3 << " us per frame, "
+                               << n << " blobs";
+            report_timer.start();
+            frames = 0;
+            processing_ns = 0;
+        }
+    }
+
+    camera->stop();
+
+    return EX_OK;
+}
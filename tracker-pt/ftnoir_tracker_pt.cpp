@@ -10,9 +10,12 @@
 #include "video/video-widget.hpp"
 #include "compat/camera-names.hpp"
 #include "compat/math-imports.hpp"
+#include "compat/rt-thread.hpp"
 
 #include "pt-api.hpp"
 
+#include <cstdlib>
+
 #include <QHBoxLayout>
 #include <QDebug>
 #include <QFile>
@@ -47,7 +50,10 @@ Tracker_PT::~Tracker_PT()
 
 void Tracker_PT::run()
 {
+    (void)rt_thread::apply(rt_thread::capture, "pt");
+
     maybe_reopen_camera();
+    start_extra_cameras();
 
     while(!isInterruptionRequested())
     {
@@ -63,39 +69,75 @@ void Tracker_PT::run()
 
         if (new_frame)
         {
-            *preview_frame = *frame;
+            using namespace time_units;
+
+            const Timer::time_type capture_ns = clock.elapsed_nsecs() - info.capture_age_ns;
+
+            // null when the widget drops this frame; the extractor still
+            // draws into the stale preview, which is cheap
+            QImage* texture = widget ? widget->begin_update() : nullptr;
+            ms preview_cost {};
+
+            if (texture)
+            {
+                Timer t;
+                *preview_frame = *frame;
+                preview_cost += t.elapsed<ms>();
+            }
 
             point_extractor->extract_points(*frame, *preview_frame, points);
             point_count = points.size();
 
+            undistort.update(s.camera_name, info.res_x, info.res_y, info.fov);
+            undistort_points(undistort, points, info.res_x, info.res_y);
+
+            lens_calibration_step();
+
             const f fx = pt_camera_info::get_focal_length(info.fov, info.res_x, info.res_y);
             const bool success = points.size() >= PointModel::N_POINTS;
 
             Affine X_CM;
+            bool solved = false;
 
             {
                 QMutexLocker l(&center_lock);
 
                 if (success)
                 {
-                    point_tracker.track(points,
-                                        PointModel(s),
-                                        info,
-                                        s.dynamic_pose ? s.init_phase_timeout : 0);
+                    solved = point_tracker.track(points,
+                                                 PointModel(s),
+                                                 info,
+                                                 s.dynamic_pose ? s.init_phase_timeout : 0,
+                                                 *s.pose_solver);
                     ever_success = true;
+                    confidence = point_tracker.confidence();
                 }
+                else
+                    confidence = 0;
 
                 QMutexLocker l2(&data_lock);
-                X_CM = point_tracker.pose();
+
+                if (fuse_extra_cameras(capture_ns, info.fps, solved))
+                    ever_success = true;
+                else
+                    X_CM_fused = point_tracker.pose();
+
+                X_CM = X_CM_fused;
             }
 
             Affine X_MH(mat33::eye(), vec3(s.t_MH_x, s.t_MH_y, s.t_MH_z));
             Affine X_GH = X_CM * X_MH;
             vec3 p = X_GH.t; // head (center?) position in global space
 
-            preview_frame->draw_head_center((p[0] * fx) / p[2], (p[1] * fx) / p[2]);
-            widget->update_image(preview_frame->get_bitmap());
+            if (texture)
+            {
+                Timer t;
+                preview_frame->draw_head_center((p[0] * fx) / p[2], (p[1] * fx) / p[2]);
+                if (preview_frame->render_to(*texture))
+                    widget->end_update(preview_cost + t.elapsed<ms>());
+            }
 
+            if (widget)
             {
                 int w = -1, h = -1;
                 widget->get_preview_size(w, h);
@@ -107,6 +149,109 @@ void Tracker_PT::run()
             }
         }
     }
+
+    QMutexLocker l(&center_lock);
+    extra_cameras.clear();
+}
+
+void Tracker_PT::start_extra_cameras()
+{
+    QMutexLocker l(&center_lock), l2(&data_lock);
+
+    extra_cameras.clear();
+    extra_relations.clear();
+
+    for (unsigned k = 0; k < pt_max_extra_cameras; k++)
+    {
+        auto cam = std::make_unique<extra_camera>(*traits, k, clock);
+        if (cam->is_enabled())
+            extra_cameras.push_back(std::move(cam));
+    }
+
+    extra_relations.resize(pt_max_extra_cameras);
+}
+
+bool Tracker_PT::fuse_extra_cameras(Timer::time_type capture_ns, f fps, bool solved)
+{
+    // unsynchronized cameras at the same rate are at most a frame apart
+    const Timer::time_type max_skew = fps > 1 ? Timer::time_type(1e9 / fps) : 50'000'000;
+
+    pose_samples.clear();
+
+    if (solved)
+        pose_samples.push_back({ point_tracker.pose(), vec3(0, 0, 0), point_tracker.confidence() });
+
+    for (const auto& cam : extra_cameras)
+    {
+        const extra_camera::result r = cam->get_result();
+
+        if (!r.ok || std::abs(r.capture_ns - capture_ns) > max_skew)
+            continue;
+
+        const Affine X_C1Ck = cam->extrinsics();
+        pose_samples.push_back({ X_C1Ck * r.X_CkM, X_C1Ck.t, r.confidence });
+
+        if (solved)
+        {
+            relation& rel = extra_relations[cam->index()];
+            rel.X_C1Ck = point_tracker.pose() * inverse(r.X_CkM);
+            rel.seq++;
+        }
+    }
+
+    return fuse_poses(pose_samples.data(), (unsigned)pose_samples.size(), X_CM_fused);
+}
+
+bool Tracker_PT::get_extra_camera_relation(unsigned idx, Affine& X_C1Ck, unsigned& seq)
+{
+    QMutexLocker l(&data_lock);
+
+    if (idx >= extra_relations.size() || extra_relations[idx].seq == 0)
+        return false;
+
+    X_C1Ck = extra_relations[idx].X_C1Ck;
+    seq = extra_relations[idx].seq;
+    return true;
+}
+
+void Tracker_PT::lens_calibration_step()
+{
+    QMutexLocker l(&lens_calib_mtx);
+
+    // finding the chessboard is slow, a few views a second are plenty
+    if (!lens_calib || lens_calib_timer.elapsed_ms() < 250)
+        return;
+
+    lens_calib_timer.start();
+
+    if (frame->to_gray(lens_calib_gray) && lens_calib->add_view(lens_calib_gray))
+        qDebug() << "pt: lens calibration view" << lens_calib->view_count();
+}
+
+void Tracker_PT::start_lens_calibration()
+{
+    QMutexLocker l(&lens_calib_mtx);
+    lens_calib = std::make_unique<lens_distortion::calibrator>();
+    lens_calib_timer.start();
+}
+
+unsigned Tracker_PT::lens_calibration_views()
+{
+    QMutexLocker l(&lens_calib_mtx);
+    return lens_calib ? lens_calib->view_count() : 0;
+}
+
+bool Tracker_PT::stop_lens_calibration(lens_distortion::model& m, double& rms)
+{
+    QMutexLocker l(&lens_calib_mtx);
+
+    if (!lens_calib)
+        return false;
+
+    const bool ret = lens_calib->calibrate(m, rms);
+    lens_calib = nullptr;
+
+    return ret;
 }
 
 bool Tracker_PT::maybe_reopen_camera()
@@ -127,6 +272,15 @@ module_status Tracker_PT::start_tracker(QFrame* video_frame)
 {
     //video_frame->setAttribute(Qt::WA_NativeWindow);
 
+    if (!video_frame)
+    {
+        // headless, the extractor skips drawing into an empty preview
+        preview_width = 0; preview_height = 0;
+        preview_frame = traits->make_preview(0, 0);
+        start(QThread::HighPriority);
+        return {};
+    }
+
     widget = std::make_unique<video_widget>(video_frame);
     layout = std::make_unique<QHBoxLayout>(video_frame);
     layout->setContentsMargins(0, 0, 0, 0);
@@ -147,7 +301,7 @@ void Tracker_PT::data(double *data)
         Affine X_CM;
         {
             QMutexLocker l(&data_lock);
-            X_CM = point_tracker.pose();
+            X_CM = X_CM_fused;
         }
 
         Affine X_MH(mat33::eye(), vec3(s.t_MH_x, s.t_MH_y, s.t_MH_z));
@@ -187,6 +341,8 @@ bool Tracker_PT::center()
     QMutexLocker l(&center_lock);
 
     point_tracker.reset_state();
+    for (auto& cam : extra_cameras)
+        cam->reset_state();
     return false;
 }
 
@@ -207,7 +363,7 @@ bool Tracker_PT::get_cam_info(pt_camera_info& info)
 Affine Tracker_PT::pose() const
 {
     QMutexLocker l(&data_lock);
-    return point_tracker.pose();
+    return X_CM_fused;
 }
 
 } // ns pt_module
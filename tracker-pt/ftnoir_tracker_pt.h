@@ -11,7 +11,10 @@
 #include "api/plugin-api.hpp"
 #include "pt-api.hpp"
 #include "point_tracker.h"
+#include "multi-camera.hpp"
 #include "cv/numeric.hpp"
+#include "cv/lens-distortion.hpp"
+#include "compat/timer.hpp"
 
 #include <atomic>
 #include <memory>
@@ -46,8 +49,20 @@ public:
     bool center() override;
 
     int  get_n_points();
+    // of the point correspondence, see PointTracker::confidence()
+    f get_confidence() const { return confidence; }
     [[nodiscard]] bool get_cam_info(pt_camera_info& info);
     Affine pose() const;
+
+    // chessboard views are collected from the camera's frames until the
+    // calibration is stopped, at which point a model is fit if possible
+    void start_lens_calibration();
+    unsigned lens_calibration_views();
+    [[nodiscard]] bool stop_lens_calibration(lens_distortion::model& m, double& rms);
+
+    // another camera's pose in the first one's frame, from the last frames
+    // both saw the model in. `seq' changes with every new measurement.
+    [[nodiscard]] bool get_extra_camera_relation(unsigned idx, Affine& X_C1Ck, unsigned& seq);
 public slots:
     bool maybe_reopen_camera();
     void set_fov(int value);
@@ -65,6 +80,26 @@ private:
     std::unique_ptr<QLayout> layout;
     std::vector<vec2> points;
 
+    lens_distortion::undistorter undistort;
+    QMutex lens_calib_mtx;
+    std::unique_ptr<lens_distortion::calibrator> lens_calib;
+    Timer lens_calib_timer;
+    cv::Mat1b lens_calib_gray;
+
+    void lens_calibration_step();
+
+    // capture times of all the cameras are on this clock
+    Timer clock;
+    std::vector<std::unique_ptr<extra_camera>> extra_cameras;
+    struct relation final { Affine X_C1Ck; unsigned seq = 0; };
+    std::vector<relation> extra_relations;
+    std::vector<pose_sample> pose_samples;
+    // all cameras' poses fused, in the first camera's frame
+    Affine X_CM_fused;
+
+    void start_extra_cameras();
+    [[nodiscard]] bool fuse_extra_cameras(Timer::time_type capture_ns, f fps, bool solved);
+
     int preview_width = 320, preview_height = 240;
 
     pointer<pt_point_extractor> point_extractor;
@@ -74,6 +109,7 @@ private:
     pointer<pt_preview> preview_frame;
 
     std::atomic<unsigned> point_count { 0 };
+    std::atomic<f> confidence { 0 };
     std::atomic<bool> ever_success { false };
     mutable QMutex center_lock, data_lock;
 };
@@ -23,13 +23,42 @@ TrackerDialog_PT::TrackerDialog_PT(const QString& module_name) :
     s(module_name),
     tracker(nullptr),
     timer(this),
-    trans_calib(1, 2)
+    trans_calib(1, 2),
+    extra_s { { module_name, 0 }, { module_name, 1 } }
 {
     Q_INIT_RESOURCE(tracker_pt_base);
 
     ui.setupUi(this);
 
+    static_assert(pt_max_extra_cameras == 2);
+    extra_ui[0] = { ui.extra_camera_2, ui.extra_fov_2, ui.extra_x_2, ui.extra_y_2, ui.extra_z_2,
+                    ui.extra_yaw_2, ui.extra_pitch_2, ui.extra_roll_2, ui.extra_measure_2 };
+    extra_ui[1] = { ui.extra_camera_3, ui.extra_fov_3, ui.extra_x_3, ui.extra_y_3, ui.extra_z_3,
+                    ui.extra_yaw_3, ui.extra_pitch_3, ui.extra_roll_3, ui.extra_measure_3 };
+
+    for (unsigned k = 0; k < pt_max_extra_cameras; k++)
+    {
+        const extra_camera_widgets& w = extra_ui[k];
+        pt_extra_camera_settings& es = extra_s[k];
+
+        w.camera->addItem(QString());
+        w.camera->addItems(get_camera_names());
+
+        tie_setting(es.camera_name, w.camera);
+        tie_setting(es.fov, w.fov);
+        tie_setting(es.x, w.x);
+        tie_setting(es.y, w.y);
+        tie_setting(es.z, w.z);
+        tie_setting(es.yaw, w.yaw);
+        tie_setting(es.pitch, w.pitch);
+        tie_setting(es.roll, w.roll);
+
+        connect(w.measure, &QPushButton::toggled, this, [this, k](bool start) { startstop_extra_measure(k, start); });
+    }
+
     ui.camdevice_combo->addItems(get_camera_names());
+    ui.camdevice_combo->addItem(pt_synthetic_camera_name);
+    ui.camdevice_combo->addItem(pt_remote_camera_name);
 
     tie_setting(s.camera_name, ui.camdevice_combo);
     tie_setting(s.cam_res_x, ui.res_x_spin);
@@ -72,6 +101,8 @@ TrackerDialog_PT::TrackerDialog_PT(const QString& module_name) :
     tie_setting(s.auto_threshold, ui.auto_threshold);
 
     connect(ui.tcalib_button,SIGNAL(toggled(bool)), this, SLOT(startstop_trans_calib(bool)));
+    connect(ui.lens_calib_button, &QPushButton::toggled, this, &TrackerDialog_PT::startstop_lens_calib);
+    connect(ui.lens_reset_button, &QPushButton::clicked, this, &TrackerDialog_PT::reset_lens_calib);
 
     connect(ui.buttonBox, SIGNAL(accepted()), this, SLOT(doOK()));
     connect(ui.buttonBox, SIGNAL(rejected()), this, SLOT(doCancel()));
@@ -103,6 +134,24 @@ TrackerDialog_PT::TrackerDialog_PT(const QString& module_name) :
 
     tie_setting(s.blob_color, ui.blob_color);
 
+    ui.pose_solver->setItemData(0, int(pt_solver_posit));
+    ui.pose_solver->setItemData(1, int(pt_solver_p3p));
+
+    tie_setting(s.pose_solver, ui.pose_solver);
+
+    ui.mjpeg_decode->setItemData(0, int(pt_mjpeg_off));
+    ui.mjpeg_decode->setItemData(1, int(pt_mjpeg_luma));
+    ui.mjpeg_decode->setItemData(2, int(pt_mjpeg_luma_half));
+    ui.mjpeg_decode->setItemData(3, int(pt_mjpeg_luma_quarter));
+
+    tie_setting(s.mjpeg_decode, ui.mjpeg_decode);
+
+    ui.blob_search->setItemData(0, int(pt_blob_search_full));
+    ui.blob_search->setItemData(1, int(pt_blob_search_coarse_2));
+    ui.blob_search->setItemData(2, int(pt_blob_search_coarse_4));
+
+    tie_setting(s.blob_search, ui.blob_search);
+
     tie_setting(s.threshold_slider, ui.threshold_value_display, [this](const slider_value& val) {
         return threshold_display_text(int(val));
     });
@@ -196,6 +245,104 @@ void TrackerDialog_PT::startstop_trans_calib(bool start)
         ui.tcalib_button->setText(tr("Start calibration"));
 }
 
+void TrackerDialog_PT::startstop_lens_calib(bool start)
+{
+    if (start)
+    {
+        if (!tracker)
+            return;
+
+        qDebug() << "pt: starting lens calibration";
+        tracker->start_lens_calibration();
+        ui.lens_calib_button->setText(tr("Stop"));
+        ui.lens_calib_status->setText(tr("Show the chessboard at different positions and angles, covering the whole frame."));
+        return;
+    }
+
+    ui.lens_calib_button->setText(tr("Calibrate"));
+
+    if (!tracker)
+    {
+        ui.lens_calib_status->setText(QString());
+        return;
+    }
+
+    const unsigned nviews = tracker->lens_calibration_views();
+    lens_distortion::model m;
+    double rms = 0;
+    pt_camera_info info;
+
+    if (tracker->stop_lens_calibration(m, rms) && tracker->get_cam_info(info))
+    {
+        lens_distortion::store(s.camera_name, m);
+
+        // the points are now undistorted into the model's field of view
+        const double fov = m.fov(info.res_x, info.res_y);
+        s.fov = iround(fov);
+
+        qDebug() << "pt: lens calibrated, views" << nviews << "rms" << rms << "fov" << fov;
+        ui.lens_calib_status->setText(tr("Calibrated from %1 views, error %2 pixels. Field of view set to %3.")
+                                      .arg(nviews).arg(rms, 0, 'f', 2).arg(iround(fov)));
+    }
+    else
+        ui.lens_calib_status->setText(tr("%1 views, at least %2 are needed. Nothing changed.")
+                                      .arg(nviews).arg(lens_distortion::calibrator::min_views));
+}
+
+void TrackerDialog_PT::reset_lens_calib()
+{
+    lens_distortion::forget(s.camera_name);
+    ui.lens_calib_status->setText(tr("Lens calibration for this camera removed."));
+}
+
+void TrackerDialog_PT::startstop_extra_measure(unsigned idx, bool start)
+{
+    extra_measurement& m = extra_measure[idx];
+    QPushButton* button = extra_ui[idx].measure;
+
+    if (start)
+    {
+        m = {};
+        button->setText(tr("Stop, %1 samples").arg(0));
+        return;
+    }
+
+    button->setText(tr("Measure position"));
+
+    // the poll timer samples four times a second, a few seconds' worth
+    constexpr unsigned min_samples = 8;
+
+    if (m.count < min_samples)
+        return;
+
+    pt_extra_camera_settings& es = extra_s[idx];
+    pt_module::set_camera_extrinsics(es, { pt_module::nearest_rotation(m.R_sum), m.t_sum * (1.f / m.count) });
+
+    qDebug() << "pt: camera" << idx + 2 << "measured from" << m.count << "samples:"
+             << *es.x << *es.y << *es.z << *es.yaw << *es.pitch << *es.roll;
+}
+
+void TrackerDialog_PT::extra_measure_step()
+{
+    for (unsigned k = 0; k < pt_max_extra_cameras; k++)
+    {
+        extra_measurement& m = extra_measure[k];
+        Affine X_C1Ck;
+        unsigned seq = 0;
+
+        if (!extra_ui[k].measure->isChecked() ||
+            !tracker->get_extra_camera_relation(k, X_C1Ck, seq) || seq == m.seq)
+            continue;
+
+        m.seq = seq;
+        m.R_sum += X_C1Ck.R;
+        m.t_sum += X_C1Ck.t;
+        m.count++;
+
+        extra_ui[k].measure->setText(tr("Stop, %1 samples").arg(m.count));
+    }
+}
+
 void TrackerDialog_PT::poll_tracker_info_impl()
 {
     pt_camera_info info;
@@ -205,7 +352,17 @@ void TrackerDialog_PT::poll_tracker_info_impl()
 
         // display point info
         const int n_points = tracker->get_n_points();
-        ui.pointinfo_label->setText((n_points == 3 ? tr("%1 OK!") : tr("%1 BAD!")).arg(n_points));
+        const double confidence = (double)tracker->get_confidence();
+
+        if (n_points > 3 && confidence > 0)
+            ui.pointinfo_label->setText(tr("%1 OK, %2% sure").arg(n_points).arg(iround(confidence * 100)));
+        else
+            ui.pointinfo_label->setText((n_points == 3 ? tr("%1 OK!") : tr("%1 BAD!")).arg(n_points));
+
+        if (ui.lens_calib_button->isChecked())
+            ui.lens_calib_button->setText(tr("Stop, %1 views").arg(tracker->lens_calibration_views()));
+
+        extra_measure_step();
     }
     else
     {
@@ -249,6 +406,8 @@ void TrackerDialog_PT::trans_calib_step()
 void TrackerDialog_PT::save()
 {
     s.b->save();
+    for (pt_extra_camera_settings& es : extra_s)
+        es.b->save();
 }
 
 void TrackerDialog_PT::doOK()
@@ -266,14 +425,24 @@ void TrackerDialog_PT::register_tracker(ITracker *t)
 {
     tracker = static_cast<Tracker_PT*>(t);
     ui.tcalib_button->setEnabled(true);
+    ui.lens_calib_button->setEnabled(true);
+    for (const extra_camera_widgets& w : extra_ui)
+        w.measure->setEnabled(true);
     poll_tracker_info();
     timer.start();
 }
 
 void TrackerDialog_PT::unregister_tracker()
 {
+    ui.lens_calib_button->setChecked(false);
+    for (const extra_camera_widgets& w : extra_ui)
+    {
+        w.measure->setChecked(false);
+        w.measure->setEnabled(false);
+    }
     tracker = nullptr;
     ui.tcalib_button->setEnabled(false);
+    ui.lens_calib_button->setEnabled(false);
     poll_tracker_info();
     timer.stop();
 }
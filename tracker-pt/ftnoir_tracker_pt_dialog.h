@@ -13,6 +13,7 @@
 #include "tracker-pt/ui_FTNoIR_PT_Controls.h"
 #include "cv/translation-calibrator.hpp"
 #include "video/video-widget.hpp"
+#include "cv/numeric.hpp"
 
 #include <QTimer>
 #include <QMutex>
@@ -31,6 +32,9 @@ public slots:
 
     void startstop_trans_calib(bool start);
     void trans_calib_step();
+    void startstop_lens_calib(bool start);
+    void reset_lens_calib();
+    void startstop_extra_measure(unsigned idx, bool start);
     void poll_tracker_info_impl();
     void set_camera_settings_available(const QString& camera_name);
     void show_camera_settings();
@@ -46,4 +50,26 @@ protected:
     QMutex calibrator_mutex;
 
     Ui::UICPTClientControls ui;
+
+    pt_extra_camera_settings extra_s[pt_max_extra_cameras];
+
+    struct extra_camera_widgets final
+    {
+        QComboBox* camera;
+        QSpinBox* fov;
+        QDoubleSpinBox *x, *y, *z, *yaw, *pitch, *roll;
+        QPushButton* measure;
+    };
+    extra_camera_widgets extra_ui[pt_max_extra_cameras] {};
+
+    // averaged while the measure button is down
+    struct extra_measurement final
+    {
+        numeric_types::mat33 R_sum = numeric_types::mat33::zeros();
+        numeric_types::vec3 t_sum { 0, 0, 0 };
+        unsigned count = 0, seq = 0;
+    };
+    extra_measurement extra_measure[pt_max_extra_cameras];
+
+    void extra_measure_step();
 };
@@ -0,0 +1,69 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// One UDP datagram per camera frame, sent by opentrack-pt-blob-server to
+// the remote camera of tracker-pt. Host byte order, both ends are
+// little-endian in practice.
+
+#include <cstdint>
+#include <cstring>
+
+namespace pt_module::blob_protocol {
+
+// "otbp", bump the version when the layout changes
+static constexpr std::uint32_t magic = 0x7062746f;
+static constexpr std::uint16_t version = 1;
+static constexpr unsigned max_blobs = 16;
+static constexpr int default_port = 4244;
+
+struct header final
+{
+    std::uint32_t magic;
+    std::uint16_t version, count;
+    // lost and reordered frames show up as gaps
+    std::uint32_t seq;
+    std::uint16_t res_x, res_y;
+    float fps;
+    // from the camera returning the frame to the datagram being sent.
+    // the receiver subtracts this from its arrival time, the sender's
+    // clock isn't comparable to its own.
+    std::uint32_t processing_ns;
+    // since the sender started, for matching against its logs
+    std::int64_t capture_ns;
+};
+
+struct blob final
+{
+    // pixels of the camera frame
+    float x, y, radius, brightness;
+};
+
+struct packet final
+{
+    header h;
+    blob blobs[max_blobs];
+
+    unsigned size() const { return sizeof(header) + h.count * sizeof(blob); }
+
+    // false unless `len' bytes hold a whole packet of this version
+    bool read(const char* data, unsigned len)
+    {
+        if (len < sizeof(header))
+            return false;
+        std::memcpy(&h, data, sizeof(header));
+        if (h.magic != magic || h.version != version || h.count > max_blobs || len < size())
+            return false;
+        std::memcpy(blobs, data + sizeof(header), h.count * sizeof(blob));
+        return true;
+    }
+};
+
+static_assert(sizeof(header) == 32 && sizeof(blob) == 16);
+
+} // ns pt_module::blob_protocol
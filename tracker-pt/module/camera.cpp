@@ -13,14 +13,19 @@
 #include "compat/math-imports.hpp"
 
 #include <opencv2/imgproc.hpp>
+#include <opencv2/imgcodecs.hpp>
 
 #include "cv/video-property-page.hpp"
 
 #include <cstdlib>
+#include <utility>
+
+#include <QDebug>
 
 namespace pt_module {
 
-Camera::Camera(const QString& module_name) : s { module_name }
+Camera::Camera(const QString& module_name, bool may_record) :
+    may_record { may_record }, s { module_name }
 {
 }
 
@@ -77,6 +82,9 @@ Camera::result Camera::get_frame(pt_frame& frame_)
         cam_info.res_y = frame.rows;
         cam_info.fov = fov;
 
+        if (recorder)
+            recorder->push(frame);
+
         return { true, cam_info };
     }
     else
@@ -91,9 +99,14 @@ bool Camera::start(int idx, int fps, int res_x, int res_y)
             (int)cam_desired.fps != fps ||
             cam_desired.res_x != res_x ||
             cam_desired.res_y != res_y ||
+            mjpeg_mode != *s.mjpeg_decode ||
             !cap || !cap->isOpened() || !cap->grab())
         {
+            // frames record their own size, a reopen at another resolution
+            // keeps appending rather than truncating what's there
+            auto rec = std::move(recorder);
             stop();
+            recorder = std::move(rec);
 
             desired_name = get_camera_names().value(idx);
             cam_desired.idx = idx;
@@ -104,6 +117,18 @@ bool Camera::start(int idx, int fps, int res_x, int res_y)
 
             cap = camera_ptr(new cv::VideoCapture(idx));
 
+            mjpeg_mode = s.mjpeg_decode;
+            raw_mjpeg = false;
+
+            // before the resolution, some drivers only apply the format then
+            if (mjpeg_mode != pt_mjpeg_off)
+            {
+                cap->set(cv::CAP_PROP_FOURCC, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'));
+                raw_mjpeg = cap->set(cv::CAP_PROP_CONVERT_RGB, 0);
+                if (!raw_mjpeg)
+                    qDebug() << "pt camera: backend can't return undecoded frames, decoding to color";
+            }
+
             if (cam_desired.res_x > 0 && cam_desired.res_y > 0)
             {
                 cap->set(cv::CAP_PROP_FRAME_WIDTH,  res_x);
@@ -124,6 +149,15 @@ bool Camera::start(int idx, int fps, int res_x, int res_y)
 
                 if (get_frame_(tmp))
                 {
+                    if (!may_record || s.record_frames->isEmpty())
+                        recorder = nullptr;
+                    else if (!recorder || recorder->filename() != *s.record_frames)
+                    {
+                        recorder = std::make_unique<frame_recording::recorder>(s.record_frames);
+                        if (!recorder->is_open())
+                            recorder = nullptr;
+                    }
+
                     t.start();
                     return true;
                 }
@@ -142,6 +176,7 @@ bool Camera::start(int idx, int fps, int res_x, int res_y)
 
 void Camera::stop()
 {
+    recorder = nullptr;
     cap = nullptr;
     desired_name = QString{};
     active_name = QString{};
@@ -149,13 +184,41 @@ void Camera::stop()
     cam_desired = {};
 }
 
+bool Camera::decode_mjpeg(cv::Mat& frame)
+{
+    if (!cap->read(mjpeg))
+        return false;
+
+    // the backend decoded it after all, e.g. the camera ignored the format
+    if (mjpeg.rows != 1 || mjpeg.type() != CV_8UC1)
+    {
+        std::swap(frame, mjpeg);
+        return true;
+    }
+
+    // the grayscale decode skips chroma's IDCT, upsampling and color
+    // conversion, the reduced ones also use the IDCT to downscale
+    int flags;
+    switch (mjpeg_mode)
+    {
+    default:
+    case pt_mjpeg_luma:         flags = cv::IMREAD_GRAYSCALE; break;
+    case pt_mjpeg_luma_half:    flags = cv::IMREAD_REDUCED_GRAYSCALE_2; break;
+    case pt_mjpeg_luma_quarter: flags = cv::IMREAD_REDUCED_GRAYSCALE_4; break;
+    }
+
+    cv::imdecode(mjpeg, flags, &frame);
+
+    return !frame.empty();
+}
+
 bool Camera::get_frame_(cv::Mat& frame)
 {
     if (cap && cap->isOpened())
     {
         for (unsigned i = 0; i < 10; i++)
         {
-            if (cap->read(frame))
+            if (raw_mjpeg ? decode_mjpeg(frame) : cap->read(frame))
                 return true;
             portable::sleep(50);
         }
@@ -9,6 +9,7 @@
 
 #include "pt-api.hpp"
 #include "compat/timer.hpp"
+#include "cv/frame-recording.hpp"
 
 #include <memory>
 
@@ -21,7 +22,8 @@ namespace pt_module {
 
 struct Camera final : pt_camera
 {
-    Camera(const QString& module_name);
+    // only the first camera writes record-frames
+    explicit Camera(const QString& module_name, bool may_record = true);
 
     bool start(int idx, int fps, int res_x, int res_y) override;
     void stop() override;
@@ -38,6 +40,7 @@ struct Camera final : pt_camera
 
 private:
     [[nodiscard]] bool get_frame_(cv::Mat& frame);
+    [[nodiscard]] bool decode_mjpeg(cv::Mat& frame);
 
     f dt_mean = 0, fov = 30;
     Timer t;
@@ -53,6 +56,13 @@ private:
     using camera_ptr = std::unique_ptr<cv::VideoCapture, camera_deleter>;
 
     camera_ptr cap;
+    // compressed frames straight from the camera, when it does MJPEG and
+    // the backend can hand them out undecoded
+    cv::Mat mjpeg;
+    pt_mjpeg_decode mjpeg_mode = pt_mjpeg_off;
+    bool raw_mjpeg = false;
+    bool may_record;
+    std::unique_ptr<frame_recording::recorder> recorder;
 
     pt_settings s;
 
@@ -1,25 +1,52 @@
 #include "frame.hpp"
 
 #include "compat/math.hpp"
+#include "cv/video-widget.hpp"
 
 #include <opencv2/imgproc.hpp>
 
 namespace pt_module {
 
+bool Frame::to_gray(cv::Mat1b& dst) const
+{
+    switch (mat.channels())
+    {
+    case 1:
+        mat.copyTo(dst);
+        return true;
+    case 3:
+        cv::cvtColor(mat, dst, cv::COLOR_BGR2GRAY);
+        return true;
+    default:
+        return false;
+    }
+}
+
 Preview& Preview::operator=(const pt_frame& frame_)
 {
     const cv::Mat& frame = frame_.as_const<const Frame>()->mat;
-    ensure_size(frame_copy, frame_out.cols, frame_out.rows, CV_8UC3);
 
-    if (frame.channels() != 3)
+    if (frame.channels() != 3 && frame.channels() != 1)
     {
         eval_once(qDebug() << "tracker/pt: camera frame depth: 3 !=" << frame.channels());
         return *this;
     }
 
-    const bool need_resize = frame.cols != frame_out.cols || frame.rows != frame_out.rows;
-    if (need_resize)
-        cv::resize(frame, frame_copy, cv::Size(frame_out.cols, frame_out.rows), 0, 0, cv::INTER_NEAREST);
+    const bool need_resize = frame.cols != frame_copy.cols || frame.rows != frame_copy.rows;
+
+    if (frame.channels() == 1)
+    {
+        // grayscale from the MJPEG decoder
+        if (need_resize)
+        {
+            cv::resize(frame, frame_gray, frame_copy.size(), 0, 0, cv::INTER_NEAREST);
+            cv::cvtColor(frame_gray, frame_copy, cv::COLOR_GRAY2BGR);
+        }
+        else
+            cv::cvtColor(frame, frame_copy, cv::COLOR_GRAY2BGR);
+    }
+    else if (need_resize)
+        cv::resize(frame, frame_copy, frame_copy.size(), 0, 0, cv::INTER_NEAREST);
     else
         frame.copyTo(frame_copy);
 
@@ -28,28 +55,20 @@ Preview& Preview::operator=(const pt_frame& frame_)
 
 Preview::Preview(int w, int h)
 {
-    ensure_size(frame_out, w, h, CV_8UC4);
+    ensure_size(frame_copy, w, h, CV_8UC3);
 
-    frame_out.setTo(cv::Scalar(0, 0, 0, 0));
+    frame_copy.setTo(cv::Scalar(0, 0, 0));
 }
 
-QImage Preview::get_bitmap()
+bool Preview::render_to(QImage& texture)
 {
-    int stride = frame_out.step.p[0];
-
-    if (stride < 64 || stride < frame_out.cols * 4)
-    {
-        eval_once(qDebug() << "bad stride" << stride
-                           << "for bitmap size" << frame_copy.cols << frame_copy.rows);
-        return QImage();
-    }
+    if (texture.width() != frame_copy.cols || texture.height() != frame_copy.rows)
+        return false;
 
-    cv::cvtColor(frame_copy, frame_out, cv::COLOR_BGR2BGRA);
+    cv::Mat dest = cv_video_widget::as_mat(texture);
+    cv::cvtColor(frame_copy, dest, cv::COLOR_BGR2BGRA);
 
-    return QImage((const unsigned char*) frame_out.data,
-                  frame_out.cols, frame_out.rows,
-                  stride,
-                  QImage::Format_ARGB32);
+    return true;
 }
 
 void Preview::draw_head_center(f x, f y)
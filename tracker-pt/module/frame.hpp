@@ -16,6 +16,8 @@ struct Frame final : pt_frame
 {
     cv::Mat mat;
 
+    bool to_gray(cv::Mat1b& dst) const override;
+
     operator const cv::Mat&() const& { return mat; }
     operator cv::Mat&() & { return mat; }
 };
@@ -25,7 +27,7 @@ struct Preview final : pt_preview
     Preview(int w, int h);
 
     Preview& operator=(const pt_frame& frame) override;
-    QImage get_bitmap() override;
+    bool render_to(QImage& texture) override;
     void draw_head_center(f x, f y) override;
 
     operator cv::Mat&() { return frame_copy; }
@@ -34,7 +36,7 @@ struct Preview final : pt_preview
 private:
     static void ensure_size(cv::Mat& frame, int w, int h, int type);
 
-    cv::Mat frame_copy, frame_out;
+    cv::Mat frame_copy, frame_gray;
 };
 
 } // ns pt_module
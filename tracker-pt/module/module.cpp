@@ -2,6 +2,9 @@
 
 #include "module.hpp"
 #include "camera.h"
+#include "synthetic-camera.hpp"
+#include "replay-camera.hpp"
+#include "remote-camera.hpp"
 #include "frame.hpp"
 #include "point_extractor.h"
 #include "ftnoir_tracker_pt_dialog.h"
@@ -22,9 +25,22 @@ struct pt_module_traits final : pt_runtime_traits
 {
     pointer<pt_camera> make_camera() const override
     {
+        const pt_settings s(module_name);
+
+        if (!s.replay_frames->isEmpty())
+            return pointer<pt_camera>(new replay_camera(module_name));
+
+        if (*s.camera_name == pt_synthetic_camera_name)
+            return pointer<pt_camera>(new synthetic_camera(module_name));
+
         return pointer<pt_camera>(new Camera(module_name));
     }
 
+    pointer<pt_camera> make_extra_camera() const override
+    {
+        return pointer<pt_camera>(new Camera(module_name, false));
+    }
+
     pointer<pt_point_extractor> make_point_extractor() const override
     {
         return pointer<pt_point_extractor>(new PointExtractor(module_name));
@@ -46,9 +62,46 @@ struct pt_module_traits final : pt_runtime_traits
     }
 };
 
+// points come over the network, there's no image processing to do
+struct pt_remote_traits final : pt_runtime_traits
+{
+    pointer<pt_camera> make_camera() const override
+    {
+        return pointer<pt_camera>(new remote_camera(module_name));
+    }
+
+    pointer<pt_point_extractor> make_point_extractor() const override
+    {
+        return pointer<pt_point_extractor>(new remote_point_extractor);
+    }
+
+    QString get_module_name() const override
+    {
+        return module_name;
+    }
+
+    pointer<pt_frame> make_frame() const override
+    {
+        return pointer<pt_frame>(new remote_frame);
+    }
+
+    pointer<pt_preview> make_preview(int w, int h) const override
+    {
+        return pointer<pt_preview>(new remote_preview(w, h));
+    }
+};
+
+static pt_pointer<pt_runtime_traits> make_traits()
+{
+    if (*pt_settings(module_name).camera_name == pt_remote_camera_name)
+        return std::make_shared<pt_remote_traits>();
+    else
+        return std::make_shared<pt_module_traits>();
+}
+
 struct tracker_pt : Tracker_PT
 {
-    tracker_pt() : Tracker_PT(pointer<pt_runtime_traits>(new pt_module_traits))
+    tracker_pt() : Tracker_PT(make_traits())
     {
     }
 };
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <cinttypes>
 #include <memory>
+#include <cstring>
 
 #include <QDebug>
 
@@ -98,7 +99,7 @@ void PointExtractor::ensure_buffers(const cv::Mat& frame)
 {
     const int W = frame.cols, H = frame.rows;
 
-    if (frame_gray.rows != W || frame_gray.cols != H)
+    if (frame_gray.cols != W || frame_gray.rows != H)
     {
         frame_gray = cv::Mat1b(H, W);
         frame_bin = cv::Mat1b(H, W);
@@ -119,6 +120,14 @@ void PointExtractor::extract_single_channel(const cv::Mat& orig_frame, int idx,
 
 void PointExtractor::color_to_grayscale(const cv::Mat& frame, cv::Mat1b& output)
 {
+    // luma-only MJPEG decode, nothing to convert. the frame outlives
+    // its use here, share the buffer rather than copying it.
+    if (frame.channels() == 1)
+    {
+        output = frame;
+        return;
+    }
+
     switch (s.blob_color)
     {
     case pt_color_green_only:
@@ -153,13 +162,14 @@ void PointExtractor::color_to_grayscale(const cv::Mat& frame, cv::Mat1b& output)
     }
 }
 
-void PointExtractor::threshold_image(const cv::Mat& frame_gray, cv::Mat1b& output)
+int PointExtractor::threshold_image(const cv::Mat& frame_gray, cv::Mat1b& output)
 {
     const int threshold_slider_value = s.threshold_slider.to<int>();
 
     if (!s.auto_threshold)
     {
         cv::threshold(frame_gray, output, threshold_slider_value, 255, cv::THRESH_BINARY);
+        return threshold_slider_value;
     }
     else
     {
@@ -192,10 +202,118 @@ void PointExtractor::threshold_image(const cv::Mat& frame_gray, cv::Mat1b& outpu
         }
 
         cv::threshold(frame_gray, output, thres, 255, cv::THRESH_BINARY);
+        return (int)thres;
+    }
+}
+
+// the cell size is a constant so that both loops vectorize
+template<int k>
+void PointExtractor::max_pool(const cv::Mat1b& src, cv::Mat1b& dst)
+{
+    const int W = src.cols, H = src.rows;
+    const int w = (W + k - 1) / k, h = (H + k - 1) / k, w_full = W / k;
+
+    dst.create(h, w);
+    pool_row.create(1, W);
+
+    unsigned char* const __restrict row = pool_row.ptr(0);
+
+    for (int y = 0; y < h; y++)
+    {
+        const int ymax = std::min(y*k + k, H);
+
+        std::memcpy(row, src.ptr(y*k), (unsigned)W);
+
+        for (int i = y*k + 1; i < ymax; i++)
+        {
+            unsigned char const* const __restrict ptr = src.ptr(i);
+            for (int x = 0; x < W; x++)
+                row[x] = std::max(row[x], ptr[x]);
+        }
+
+        unsigned char* const __restrict out = dst.ptr(y);
+
+        for (int x = 0; x < w_full; x++)
+        {
+            unsigned char val = row[x*k];
+            for (int j = 1; j < k; j++)
+                val = std::max(val, row[x*k + j]);
+            out[x] = val;
+        }
+
+        // partial cell at the right edge
+        if (w_full < w)
+        {
+            unsigned char val = row[w_full*k];
+            for (int j = w_full*k + 1; j < W; j++)
+                val = std::max(val, row[j]);
+            out[w_full] = val;
+        }
+    }
+}
+
+void PointExtractor::find_blobs_coarse(int k)
+{
+    // a pixel over the threshold makes its whole cell of the max-pooled
+    // frame go over too, so each blob at full resolution lies within the
+    // bounding box of a coarse one, scaled back up. only those boxes get
+    // thresholded and labeled at full resolution.
+
+    if (k == 4)
+        max_pool<4>(frame_gray_unmasked, frame_pooled);
+    else
+        max_pool<2>(frame_gray_unmasked, frame_pooled);
+    // the auto threshold's expected blob area shrinks with the frame
+    const int thres = threshold_image(frame_pooled, frame_pooled_bin);
+
+    const cv::Rect bounds(0, 0, frame_gray_unmasked.cols, frame_gray_unmasked.rows);
+
+    candidates.clear();
+
+    for (int y = 0; y < frame_pooled_bin.rows; y++)
+    {
+        const unsigned char* __restrict ptr_bin = frame_pooled_bin.ptr(y);
+        for (int x = 0; x < frame_pooled_bin.cols; x++)
+        {
+            if (ptr_bin[x] != 255)
+                continue;
+
+            cv::Rect rect;
+            cv::floodFill(frame_pooled_bin,
+                          cv::Point(x, y),
+                          cv::Scalar(1),
+                          &rect,
+                          cv::Scalar(0),
+                          cv::Scalar(0),
+                          4 | cv::FLOODFILL_FIXED_RANGE);
+
+            candidates.push_back(cv::Rect(rect.x * k, rect.y * k, rect.width * k, rect.height * k) & bounds);
+
+            if (candidates.size() >= max_candidates)
+                goto end;
+        }
     }
+end:
+
+    // with a margin for the mean shift's window, which is twice the size
+    // of the blob's bounding box. everything read later is in there.
+    for (const cv::Rect& rect : candidates)
+    {
+        const cv::Rect roi = cv::Rect(rect.x - rect.width/2 - 1,
+                                      rect.y - rect.height/2 - 1,
+                                      rect.width*2 + 2,
+                                      rect.height*2 + 2) & bounds;
+
+        cv::threshold(frame_gray_unmasked(roi), frame_bin(roi), thres, 255, cv::THRESH_BINARY);
+        cv::bitwise_and(frame_gray_unmasked(roi), frame_bin(roi), frame_gray(roi));
+    }
+
+    for (const cv::Rect& rect : candidates)
+        if (!find_blobs(rect))
+            break;
 }
 
-static void draw_blobs(cv::Mat& preview_frame, const blob* blobs, unsigned nblobs, const cv::Size& size)
+void draw_blobs(cv::Mat& preview_frame, const blob* blobs, unsigned nblobs, const cv::Size& size)
 {
     for (unsigned k = 0; k < nblobs; k++)
     {
@@ -241,32 +359,17 @@ static void draw_blobs(cv::Mat& preview_frame, const blob* blobs, unsigned nblob
     }
 }
 
-void PointExtractor::extract_points(const pt_frame& frame_, pt_preview& preview_frame_, std::vector<vec2>& points)
+bool PointExtractor::find_blobs(const cv::Rect& roi)
 {
-    const cv::Mat& frame = frame_.as_const<Frame>()->mat;
-
-    ensure_buffers(frame);
-    color_to_grayscale(frame, frame_gray_unmasked);
-
-#if defined PREVIEW
-    cv::imshow("capture", frame_gray);
-    cv::waitKey(1);
-#endif
-
-    threshold_image(frame_gray_unmasked, frame_bin);
-    frame_gray_unmasked.copyTo(frame_gray, frame_bin);
-
     const f region_size_min = (f)s.min_point_size;
     const f region_size_max = (f)s.max_point_size;
 
     unsigned idx = 0;
 
-    blobs.clear();
-
-    for (int y=0; y < frame_bin.rows; y++)
+    for (int y=roi.y; y < roi.y + roi.height; y++)
     {
         const unsigned char* __restrict ptr_bin = frame_bin.ptr(y);
-        for (int x=0; x < frame_bin.cols; x++)
+        for (int x=roi.x; x < roi.x + roi.width; x++)
         {
             if (ptr_bin[x] != 255)
                 continue;
@@ -312,7 +415,7 @@ void PointExtractor::extract_points(const pt_frame& frame_, pt_preview& preview_
                                rect);
 
             if (idx >= max_blobs)
-                goto end;
+                return false;
 
             // XXX we could go to the next scanline unless the points are really small.
             // i'd expect each point being present on at least one unique scanline
@@ -320,7 +423,32 @@ void PointExtractor::extract_points(const pt_frame& frame_, pt_preview& preview_
             //break;
         }
     }
-end:
+    return true;
+}
+
+void PointExtractor::extract_points(const pt_frame& frame_, pt_preview& preview_frame_, std::vector<vec2>& points)
+{
+    const cv::Mat& frame = frame_.as_const<Frame>()->mat;
+
+    ensure_buffers(frame);
+    color_to_grayscale(frame, frame_gray_unmasked);
+
+#if defined PREVIEW
+    cv::imshow("capture", frame_gray);
+    cv::waitKey(1);
+#endif
+
+    blobs.clear();
+
+    if (const int k = *s.blob_search; k == 2 || k == 4)
+        find_blobs_coarse(k);
+    else
+    {
+        threshold_image(frame_gray_unmasked, frame_bin);
+        // the mask is 0 or 255, also clears what was left from the last frame
+        cv::bitwise_and(frame_gray_unmasked, frame_bin, frame_gray);
+        (void)find_blobs(cv::Rect(0, 0, frame_bin.cols, frame_bin.rows));
+    }
 
     const int W = frame_gray.cols;
     const int H = frame_gray.rows;
@@ -361,9 +489,10 @@ end:
         b.pos[1] = pos[1] + rect.y;
     }
 
-    draw_blobs(preview_frame_.as<Frame>()->mat,
-               blobs.data(), blobs.size(),
-               frame_gray.size());
+    if (cv::Mat& preview_frame = preview_frame_.as<Frame>()->mat; !preview_frame.empty())
+        draw_blobs(preview_frame,
+                   blobs.data(), blobs.size(),
+                   frame_gray.size());
 
 
     // End of mean shift code. At this point, blob positions are updated with hopefully less noisy less biased values.
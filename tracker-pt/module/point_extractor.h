@@ -28,6 +28,9 @@ struct blob final
     blob(f radius, const vec2& pos, f brightness, const cv::Rect& rect);
 };
 
+// `size' is the camera frame's, the preview can be any size
+void draw_blobs(cv::Mat& preview_frame, const blob* blobs, unsigned nblobs, const cv::Size& size);
+
 class PointExtractor final : public pt_point_extractor
 {
 public:
@@ -35,12 +38,20 @@ public:
     // dt: time since last call in seconds
     void extract_points(const pt_frame& frame, pt_preview& preview_frame, std::vector<vec2>& points) override;
     PointExtractor(const QString& module_name);
+
+    // from the last extract_points(), brightest first and in the same
+    // order as its points, in pixels of the camera frame
+    const std::vector<blob>& get_blobs() const { return blobs; }
 private:
     static constexpr int max_blobs = 16;
+    // coarse blobs looked at more closely, reflections included
+    static constexpr unsigned max_candidates = 4 * max_blobs;
 
     pt_settings s;
 
     cv::Mat1b frame_gray_unmasked, frame_bin, frame_gray;
+    cv::Mat1b frame_pooled, frame_pooled_bin, pool_row;
+    std::vector<cv::Rect> candidates;
     cv::Mat1f hist;
     std::vector<blob> blobs;
     cv::Mat1b ch[3];
@@ -51,7 +62,13 @@ private:
     void extract_single_channel(const cv::Mat& orig_frame, int idx, cv::Mat1b& dest);
 
     void color_to_grayscale(const cv::Mat& frame, cv::Mat1b& output);
-    void threshold_image(const cv::Mat& frame_gray, cv::Mat1b& output);
+    // returns the threshold used
+    int threshold_image(const cv::Mat& frame_gray, cv::Mat1b& output);
+
+    // labels blobs starting within roi, false once there's max_blobs
+    [[nodiscard]] bool find_blobs(const cv::Rect& roi);
+    void find_blobs_coarse(int k);
+    template<int k> void max_pool(const cv::Mat1b& src, cv::Mat1b& dst);
 };
 
 } // ns impl
@@ -0,0 +1,189 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "remote-camera.hpp"
+
+#include "compat/macros.hpp"
+#include "compat/sleep.hpp"
+
+#include <QHostAddress>
+#include <QDebug>
+
+namespace pt_module {
+
+remote_camera_settings::remote_camera_settings() : opts("tracker-pt-remote") {}
+
+remote_preview::remote_preview(int w, int h) : preview(w, h)
+{
+}
+
+remote_preview& remote_preview::operator=(const pt_frame&)
+{
+    cv::Mat& m = mat();
+    if (!m.empty())
+        m.setTo(cv::Scalar(32, 32, 32));
+    return *this;
+}
+
+remote_camera::remote_camera(const QString& module_name) : s { module_name }
+{
+}
+
+remote_camera::~remote_camera()
+{
+    stop();
+    // the tracker thread is gone by now
+    sock = nullptr;
+}
+
+QString remote_camera::get_desired_name() const
+{
+    return QStringLiteral("%1 :%2").arg(pt_remote_camera_name).arg(*rs.port);
+}
+
+QString remote_camera::get_active_name() const
+{
+    return sender;
+}
+
+pt_camera::result remote_camera::get_info() const
+{
+    if (cam_info.res_x == 0 || cam_info.res_y == 0)
+        return { false, pt_camera_info() };
+    else
+        return { true, cam_info };
+}
+
+bool remote_camera::start(int idx, int fps, int res_x, int res_y)
+{
+    // resolution and rate are the sender's, these are only reported back
+    cam_desired.idx = idx;
+    cam_desired.fps = fps;
+    cam_desired.res_x = res_x;
+    cam_desired.res_y = res_y;
+    cam_desired.fov = fov;
+
+    if (!active)
+    {
+        cam_info = {};
+        cam_info.idx = idx;
+        last_seq = 0;
+        lost = 0;
+        active = true;
+    }
+
+    return true;
+}
+
+void remote_camera::stop()
+{
+    if (lost)
+        qDebug() << "pt remote: lost" << lost << "frames";
+
+    lost = 0;
+    active = false;
+    sender = QString{};
+    cam_info = {};
+    cam_desired = {};
+}
+
+bool remote_camera::bind()
+{
+    sock = std::make_unique<QUdpSocket>();
+
+    if (!sock->bind(QHostAddress::Any, quint16(*rs.port), QUdpSocket::DontShareAddress))
+    {
+        eval_once(qDebug() << "pt remote: can't bind port" << *rs.port << sock->errorString());
+        sock = nullptr;
+        return false;
+    }
+
+    qDebug() << "pt remote: listening on port" << *rs.port;
+
+    return true;
+}
+
+pt_camera::result remote_camera::get_frame(pt_frame& frame_)
+{
+    if (!active)
+        return { false, {} };
+
+    if (!sock && !bind())
+    {
+        portable::sleep(500);
+        return { false, {} };
+    }
+
+    if (!sock->hasPendingDatagrams() && !sock->waitForReadyRead(100))
+        return { false, {} };
+
+    remote_frame& frame = *frame_.as<remote_frame>();
+    bool ok = false;
+    QHostAddress addr;
+
+    // only the newest frame matters, drop anything queued behind a stall
+    while (sock->hasPendingDatagrams())
+    {
+        const qint64 sz = sock->readDatagram(buf, sizeof(buf), &addr);
+
+        if (sz > 0 && next.read(buf, unsigned(sz)))
+        {
+            frame.packet = next;
+            ok = true;
+        }
+    }
+
+    if (!ok)
+        return { false, {} };
+
+    const blob_protocol::header& h = frame.packet.h;
+
+    if (sender.isEmpty())
+    {
+        sender = addr.toString();
+        qDebug() << "pt remote: receiving from" << sender << h.res_x << "x" << h.res_y << "at" << h.fps << "fps";
+    }
+    else if (const auto gap = std::int32_t(h.seq - last_seq); gap > 1)
+        lost += unsigned(gap - 1);
+
+    last_seq = h.seq;
+
+    cam_info.res_x = h.res_x;
+    cam_info.res_y = h.res_y;
+    cam_info.fps = h.fps;
+    cam_info.fov = fov;
+    // just the sender's processing time. the network's latency isn't
+    // known, on a LAN it's well under a millisecond.
+    cam_info.capture_age_ns = h.processing_ns;
+
+    return { true, cam_info };
+}
+
+void remote_point_extractor::extract_points(const pt_frame& frame, pt_preview& preview, std::vector<vec2>& points)
+{
+    const blob_protocol::packet& p = frame.as_const<remote_frame>()->packet;
+    const int W = p.h.res_x, H = p.h.res_y;
+
+    blobs.clear();
+    points.clear();
+
+    for (unsigned k = 0; k < p.h.count; k++)
+    {
+        const blob_protocol::blob& b = p.blobs[k];
+
+        blobs.emplace_back(b.radius, vec2(b.x, b.y), b.brightness, cv::Rect());
+
+        vec2 pos;
+        std::tie(pos[0], pos[1]) = to_screen_pos(b.x, b.y, W, H);
+        points.push_back(pos);
+    }
+
+    if (cv::Mat& preview_frame = preview.as<remote_preview>()->mat(); !preview_frame.empty())
+        draw_blobs(preview_frame, blobs.data(), (unsigned)blobs.size(), cv::Size(W, H));
+}
+
+} // ns pt_module
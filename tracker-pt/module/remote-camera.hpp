@@ -0,0 +1,104 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// The receiving end of opentrack-pt-blob-server. Frames are blob lists
+// rather than pixels, so the camera, frame, preview and extractor all
+// come as a set, see pt_remote_traits in module.cpp.
+
+#include "pt-api.hpp"
+#include "blob-protocol.hpp"
+#include "frame.hpp"
+#include "point_extractor.h"
+#include "options/options.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QString>
+#include <QUdpSocket>
+
+namespace pt_module {
+
+using namespace options;
+
+struct remote_camera_settings final : opts
+{
+    value<int> port { b, "port", blob_protocol::default_port };
+
+    remote_camera_settings();
+};
+
+struct remote_frame final : pt_frame
+{
+    blob_protocol::packet packet {};
+};
+
+struct remote_preview final : pt_preview
+{
+    remote_preview(int w, int h);
+
+    // there are no pixels, clears the preview for drawing blobs into
+    remote_preview& operator=(const pt_frame& frame) override;
+    bool render_to(QImage& texture) override { return preview.render_to(texture); }
+    void draw_head_center(f x, f y) override { preview.draw_head_center(x, y); }
+
+    cv::Mat& mat() { return preview; }
+
+private:
+    Preview preview;
+};
+
+struct remote_camera final : pt_camera
+{
+    explicit remote_camera(const QString& module_name);
+    ~remote_camera() override;
+
+    bool start(int idx, int fps, int res_x, int res_y) override;
+    void stop() override;
+
+    result get_frame(pt_frame& frame) override;
+    result get_info() const override;
+
+    pt_camera_info get_desired() const override { return cam_desired; }
+    QString get_desired_name() const override;
+    QString get_active_name() const override;
+
+    void set_fov(f value) override { fov = value; }
+    void show_camera_settings() override {}
+
+private:
+    bool bind();
+
+    pt_settings s;
+    remote_camera_settings rs;
+
+    // created and read on the tracker thread
+    std::unique_ptr<QUdpSocket> sock;
+    blob_protocol::packet next {};
+    char buf[sizeof(blob_protocol::packet)];
+
+    pt_camera_info cam_info, cam_desired;
+    f fov = 56;
+    bool active = false;
+
+    QString sender;
+    std::uint32_t last_seq = 0;
+    unsigned lost = 0;
+};
+
+struct remote_point_extractor final : pt_point_extractor
+{
+    void extract_points(const pt_frame& frame, pt_preview& preview, std::vector<vec2>& points) override;
+
+private:
+    std::vector<blob> blobs;
+};
+
+} // ns pt_module
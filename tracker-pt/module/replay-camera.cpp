@@ -0,0 +1,124 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "replay-camera.hpp"
+#include "frame.hpp"
+
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+
+#include <QFileInfo>
+#include <QDebug>
+
+namespace pt_module {
+
+replay_camera::replay_camera(const QString& module_name) : s { module_name }
+{
+}
+
+QString replay_camera::get_desired_name() const
+{
+    return QFileInfo(*s.replay_frames).fileName();
+}
+
+QString replay_camera::get_active_name() const
+{
+    return active ? get_desired_name() : QString{};
+}
+
+pt_camera::result replay_camera::get_info() const
+{
+    if (!active)
+        return { false, pt_camera_info() };
+    else
+        return { true, cam_info };
+}
+
+bool replay_camera::start(int idx, int fps, int res_x, int res_y)
+{
+    if (active)
+        return true;
+
+    cam_desired.idx = idx;
+    cam_desired.fps = fps;
+    cam_desired.res_x = res_x;
+    cam_desired.res_y = res_y;
+    cam_desired.fov = fov;
+
+    if (!replay.open(s.replay_frames))
+        return false;
+
+    // the requested resolution and rate are whatever was recorded
+    const cv::Size size = replay.frame_size(0);
+
+    cam_info = {};
+    cam_info.idx = idx;
+    cam_info.res_x = size.width;
+    cam_info.res_y = size.height;
+    cam_info.fps = replay.fps();
+    cam_info.fov = fov;
+
+    frame_idx = 0;
+    loop_offset_ns = 0;
+    epoch = clock::now();
+    active = true;
+
+    qDebug() << "pt replay:" << replay.size() << "frames" << size.width << "x" << size.height
+             << "at" << cam_info.fps << "fps";
+
+    return true;
+}
+
+void replay_camera::stop()
+{
+    active = false;
+    replay.close();
+    cam_info = {};
+    cam_desired = {};
+}
+
+pt_camera::result replay_camera::get_frame(pt_frame& frame)
+{
+    if (!active)
+        return { false, {} };
+
+    if (frame_idx >= replay.size())
+    {
+        // keep the time going forward over the loop, one mean frame
+        // interval between the last frame and the first
+        const std::int64_t first = replay.timestamp_ns(0), last = replay.timestamp_ns(replay.size() - 1);
+        loop_offset_ns += last - first + (cam_info.fps > 0 ? std::int64_t(1e9 / cam_info.fps) : 0);
+        frame_idx = 0;
+    }
+
+    if (s.replay_realtime)
+    {
+        const std::int64_t ts = replay.timestamp_ns(frame_idx) - replay.timestamp_ns(0) + loop_offset_ns;
+        const clock::time_point when = epoch + std::chrono::nanoseconds(ts);
+        const clock::time_point now = clock::now();
+
+        // don't catch up in a burst after a stall
+        if (now - when > std::chrono::milliseconds(100))
+            epoch += now - when;
+        else
+            std::this_thread::sleep_until(when);
+    }
+
+    if (!replay.read(frame_idx++, gray))
+    {
+        qDebug() << "pt replay: corrupted frame" << frame_idx - 1;
+        return { false, {} };
+    }
+
+    cv::cvtColor(gray, frame.as<Frame>()->mat, cv::COLOR_GRAY2BGR);
+    cam_info.fov = fov;
+
+    return { true, cam_info };
+}
+
+} // ns pt_module
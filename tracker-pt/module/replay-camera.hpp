@@ -0,0 +1,58 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include "pt-api.hpp"
+#include "cv/frame-recording.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+#include <opencv2/core.hpp>
+
+#include <QString>
+
+namespace pt_module {
+
+// plays back frames saved by the camera's recorder, looping at the end
+struct replay_camera final : pt_camera
+{
+    explicit replay_camera(const QString& module_name);
+
+    bool start(int idx, int fps, int res_x, int res_y) override;
+    void stop() override;
+
+    result get_frame(pt_frame& frame) override;
+    result get_info() const override;
+
+    pt_camera_info get_desired() const override { return cam_desired; }
+    QString get_desired_name() const override;
+    QString get_active_name() const override;
+
+    void set_fov(f value) override { fov = value; }
+    void show_camera_settings() override {}
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    pt_settings s;
+    frame_recording::replay replay;
+
+    pt_camera_info cam_info, cam_desired;
+    f fov = 56;
+    bool active = false;
+
+    cv::Mat1b gray;
+    unsigned frame_idx = 0;
+    // wall clock time of the recording's first frame, moved forward on
+    // every loop and after stalls
+    clock::time_point epoch;
+    std::int64_t loop_offset_ns = 0;
+};
+
+} // ns pt_module
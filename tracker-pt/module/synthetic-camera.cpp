@@ -0,0 +1,336 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "synthetic-camera.hpp"
+#include "frame.hpp"
+#include "point_tracker.h"
+
+#include "api/plugin-api.hpp"
+#include "compat/math.hpp"
+#include "compat/math-imports.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+namespace pt_module {
+
+// background level of the frame, the noise is around it
+static constexpr double background = 16;
+// rows of noise beyond the frame's height, each frame starts at a random one
+static constexpr int noise_slack = 64;
+
+synthetic_camera_settings::synthetic_camera_settings() : opts("tracker-pt-synthetic") {}
+
+synthetic_camera::synthetic_camera(const QString& module_name) : s { module_name }
+{
+}
+
+QString synthetic_camera::get_desired_name() const
+{
+    return pt_synthetic_camera_name;
+}
+
+QString synthetic_camera::get_active_name() const
+{
+    return active ? pt_synthetic_camera_name : QString{};
+}
+
+pt_camera::result synthetic_camera::get_info() const
+{
+    if (!active)
+        return { false, pt_camera_info() };
+    else
+        return { true, cam_info };
+}
+
+bool synthetic_camera::start(int idx, int fps, int res_x, int res_y)
+{
+    stop();
+
+    cam_desired.idx = idx;
+    cam_desired.fps = fps;
+    cam_desired.res_x = res_x;
+    cam_desired.res_y = res_y;
+    cam_desired.fov = fov;
+
+    const int w = res_x > 0 ? res_x : 640, h = res_y > 0 ? res_y : 480;
+
+    cam_info = {};
+    cam_info.idx = idx;
+    cam_info.res_x = w;
+    cam_info.res_y = h;
+    cam_info.fps = fps > 0 ? fps : 60;
+
+    if (!ss.pose_file->isEmpty() && !load_poses(ss.pose_file))
+        return false;
+
+    rng.seed((unsigned)*ss.seed);
+
+    // noise is generated once, per-pixel random numbers would cost more
+    // than the extractor at high resolutions
+    noise.create(h + noise_slack, w);
+    cv::RNG(std::uint64_t(*ss.seed)).fill(noise, cv::RNG::NORMAL, background, std::fmax(0., *ss.noise));
+    gray.create(h, w);
+
+    std::uniform_real_distribution<float> uniform(0, 1);
+    reflections.resize((unsigned)std::max(0, *ss.reflections));
+    for (cv::Point2f& p : reflections)
+        p = { uniform(rng), uniform(rng) };
+
+    if (!ss.truth_file->isEmpty())
+    {
+        truth.open(ss.truth_file->toStdString());
+        if (!truth.is_open())
+            qDebug() << "pt synthetic: can't write" << *ss.truth_file;
+    }
+
+    frame_idx = 0;
+    next_frame = clock::now();
+    active = true;
+
+    return true;
+}
+
+void synthetic_camera::stop()
+{
+    active = false;
+    truth.close();
+    poses.clear();
+    pose_times.clear();
+    cam_info = {};
+    cam_desired = {};
+}
+
+pt_camera::result synthetic_camera::get_frame(pt_frame& frame)
+{
+    if (!active)
+        return { false, {} };
+
+    const double period = 1. / (double)cam_info.fps;
+
+    if (ss.realtime)
+    {
+        const auto dt = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(period));
+        std::this_thread::sleep_until(next_frame);
+        next_frame += dt;
+        // don't catch up in a burst after a stall
+        if (clock::now() - next_frame > 2 * dt)
+            next_frame = clock::now();
+    }
+
+    // the scene's own clock, so that runs are repeatable
+    const double time = frame_idx * period;
+
+    pose p;
+    get_pose(time, p);
+    render(camera_from_head(p), frame.as<Frame>()->mat);
+
+    if (truth.is_open())
+    {
+        truth << frame_idx << ',' << time;
+        for (double x : p)
+            truth << ',' << x;
+        truth << '\n';
+    }
+
+    frame_idx++;
+    cam_info.fov = fov;
+
+    return { true, cam_info };
+}
+
+void synthetic_camera::get_pose(double time, pose& p) const
+{
+    if (!poses.empty())
+    {
+        // loop the recording
+        time = std::fmod(time, pose_times.back());
+
+        const unsigned k = unsigned(std::upper_bound(pose_times.cbegin(), pose_times.cend(), time) - pose_times.cbegin());
+
+        if (k == 0 || k >= poses.size())
+        {
+            p = poses[k == 0 ? 0 : poses.size() - 1];
+            return;
+        }
+
+        const double t0 = pose_times[k-1], t1 = pose_times[k];
+        const double alpha = t1 > t0 ? (time - t0) / (t1 - t0) : 0;
+
+        for (unsigned i = 0; i < 6; i++)
+            p[i] = poses[k-1][i] + alpha * (poses[k][i] - poses[k-1][i]);
+
+        return;
+    }
+
+    const double T = std::fmax(.1, *ss.period);
+    auto sine = [time, T](double amplitude, double period_scale) {
+        return amplitude * sin(2*M_PI * time / (T * period_scale));
+    };
+
+    p[TX] = sine(*ss.x, 1.1);
+    p[TY] = sine(*ss.y, 1.5);
+    p[TZ] = *ss.distance + sine(*ss.z, 1.9);
+    p[Yaw] = sine(*ss.yaw, 1);
+    p[Pitch] = sine(*ss.pitch, 1.3);
+    p[Roll] = sine(*ss.roll, 1.7);
+}
+
+// inverse of Tracker_PT::data()
+Affine synthetic_camera::camera_from_head(const pose& p) const
+{
+    constexpr double d2r = M_PI / 180;
+
+    const double alpha = p[Yaw] * d2r, beta = -p[Pitch] * d2r, gamma = p[Roll] * d2r;
+    const double ca = cos(alpha), sa = sin(alpha);
+    const double cb = cos(beta), sb = sin(beta);
+    const double cg = cos(gamma), sg = sin(gamma);
+
+    // Rz(alpha) Ry(beta) Rx(gamma)
+    const mat33 R_E(f(ca*cb), f(ca*sb*sg - sa*cg), f(ca*sb*cg + sa*sg),
+                    f(sa*cb), f(sa*sb*sg + ca*cg), f(sa*sb*cg - ca*sg),
+                    f(-sb),   f(cb*sg),            f(cb*cg));
+
+    const mat33 R_EG(0, 0,-1,
+                     -1, 0, 0,
+                     0, 1, 0);
+    const mat33 R_GH = R_EG.t() * R_E * R_EG;
+
+    const vec3 t_GH(f(p[TX] * 10), f(p[TY] * 10), f(p[TZ] * 10));
+    const vec3 t_MH(s.t_MH_x, s.t_MH_y, s.t_MH_z);
+
+    return { R_GH, t_GH - R_GH * t_MH };
+}
+
+void synthetic_camera::render(const Affine& X_CM, cv::Mat& frame)
+{
+    const int w = gray.cols, h = gray.rows;
+    const f fx = pt_camera_info::get_focal_length(fov, w, h);
+    const f radius = f(std::fmax(.5, *ss.blob_radius) * w / 640);
+    const double dropout = *ss.dropout;
+
+    std::uniform_int_distribution<int> row(0, noise_slack);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    noise(cv::Rect(0, row(rng), w, h)).copyTo(gray);
+
+    const PointModel model(s);
+    const vec3 points[] = { { 0, 0, 0 }, model.M01, model.M02 };
+
+    for (const vec3& point : points)
+    {
+        if (uniform(rng) < dropout)
+            continue;
+
+        const vec3 v = X_CM * point;
+        if (v[2] <= 0)
+            continue;
+
+        const auto [px, py] = pt_pixel_pos_mixin::to_pixel_pos(fx * v[0] / v[2], fx * v[1] / v[2], w, h);
+        draw_blob(px, py, radius, 255);
+    }
+
+    for (const cv::Point2f& p : reflections)
+        draw_blob(p.x * w, p.y * h, radius * f(.6), 192);
+
+    cv::cvtColor(gray, frame, cv::COLOR_GRAY2BGR);
+}
+
+void synthetic_camera::draw_blob(f px, f py, f radius, f brightness)
+{
+    const f sigma = f(std::fmax(0., *ss.blur));
+    const f extent = radius + 3 * sigma + 1;
+
+    const int x0 = std::max(0, int(px - extent)), x1 = std::min(gray.cols - 1, int(px + extent));
+    const int y0 = std::max(0, int(py - extent)), y1 = std::min(gray.rows - 1, int(py + extent));
+
+    // a disc convolved with a gaussian, approximated radially
+    const f scale = sigma > 0 ? 1 / (f(M_SQRT2) * sigma) : 0;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        unsigned char* line = gray.ptr<unsigned char>(y);
+
+        for (int x = x0; x <= x1; x++)
+        {
+            const f d = std::sqrt((x - px)*(x - px) + (y - py)*(y - py));
+            const f coverage = sigma > 0 ? f(.5) * std::erfc((d - radius) * scale) : f(d <= radius);
+            const f value = line[x] + (brightness - line[x]) * coverage;
+
+            line[x] = (unsigned char)clamp(value + f(.5), f(0), f(255));
+        }
+    }
+}
+
+bool synthetic_camera::load_poses(const QString& filename)
+{
+    QFile f(filename);
+    if (!f.open(QFile::ReadOnly | QFile::Text))
+    {
+        qDebug() << "pt synthetic: can't open" << filename << f.errorString();
+        return false;
+    }
+
+    QTextStream stream(&f);
+    const QStringList header = stream.readLine().split(',');
+
+    static const char* const axes[6] = { "TX", "TY", "TZ", "Yaw", "Pitch", "Roll" };
+    const int dt_col = header.indexOf("dt");
+    int cols[6];
+
+    for (unsigned i = 0; i < 6; i++)
+        cols[i] = header.indexOf(QStringLiteral("raw%1").arg(axes[i]));
+
+    if (dt_col == -1 || std::count(cols, cols + 6, -1))
+    {
+        qDebug() << "pt synthetic:" << filename << "isn't a tracklogger recording";
+        return false;
+    }
+
+    double time = 0;
+
+    while (!stream.atEnd())
+    {
+        const QStringList row = stream.readLine().split(',');
+        if (row.size() != header.size())
+            continue;
+
+        pose p;
+        bool ok = true;
+        const double dt = row[dt_col].toDouble(&ok);
+
+        for (unsigned i = 0; ok && i < 6; i++)
+            p[i] = row[cols[i]].toDouble(&ok);
+
+        if (!ok)
+            continue;
+
+        time += dt;
+        pose_times.push_back(time);
+        poses.push_back(p);
+    }
+
+    if (poses.size() < 2)
+    {
+        qDebug() << "pt synthetic:" << filename << "has no poses";
+        poses.clear();
+        pose_times.clear();
+        return false;
+    }
+
+    return true;
+}
+
+} // ns pt_module
@@ -0,0 +1,114 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include "pt-api.hpp"
+#include "cv/affine.hpp"
+#include "options/options.hpp"
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include <QString>
+
+namespace pt_module {
+
+using namespace options;
+
+struct synthetic_camera_settings final : opts
+{
+    // empty for the scripted sweep, else a tracklogger .csv whose "raw"
+    // columns are replayed as the head pose
+    value<QString> pose_file { b, "pose-file", "" };
+
+    // scripted sweep, a sine per axis with slightly different periods so
+    // the path doesn't repeat. seconds, degrees and centimeters.
+    value<double> period { b, "period", 8 },
+                  yaw { b, "yaw-amplitude", 30 },
+                  pitch { b, "pitch-amplitude", 15 },
+                  roll { b, "roll-amplitude", 5 },
+                  x { b, "x-amplitude", 5 },
+                  y { b, "y-amplitude", 5 },
+                  z { b, "z-amplitude", 5 },
+                  distance { b, "distance", 60 };
+
+    // radius in pixels at 640 wide, scaled with the resolution. blur is a
+    // gaussian's sigma in pixels, noise a stddev in 8-bit levels.
+    value<double> blob_radius { b, "blob-radius", 3 },
+                  blur { b, "blur", .75 },
+                  noise { b, "noise", 2 },
+                  // chance of each point missing from a frame
+                  dropout { b, "dropout", 0 };
+    // static blobs that aren't part of the model
+    value<int> reflections { b, "reflections", 0 };
+    value<int> seed { b, "seed", 1 };
+    // pace frames to the requested rate, else render them as fast as
+    // they're consumed. the scene's clock advances by 1/fps either way.
+    value<bool> realtime { b, "realtime", true };
+    // if set, each frame's pose is written here in the tracker's output
+    // convention: frame,time,TX,TY,TZ,Yaw,Pitch,Roll
+    value<QString> truth_file { b, "ground-truth-file", "" };
+
+    synthetic_camera_settings();
+};
+
+// renders the configured point model at a known head pose, for
+// exercising the extractor and solver without a camera
+struct synthetic_camera final : pt_camera
+{
+    explicit synthetic_camera(const QString& module_name);
+
+    bool start(int idx, int fps, int res_x, int res_y) override;
+    void stop() override;
+
+    result get_frame(pt_frame& frame) override;
+    result get_info() const override;
+
+    pt_camera_info get_desired() const override { return cam_desired; }
+    QString get_desired_name() const override;
+    QString get_active_name() const override;
+
+    void set_fov(f value) override { fov = value; }
+    void show_camera_settings() override {}
+
+private:
+    using clock = std::chrono::steady_clock;
+    using pose = std::array<double, 6>;
+
+    void get_pose(double time, pose& p) const;
+    Affine camera_from_head(const pose& p) const;
+    void render(const Affine& X_CM, cv::Mat& frame);
+    void draw_blob(f px, f py, f radius, f brightness);
+    bool load_poses(const QString& filename);
+
+    pt_settings s;
+    synthetic_camera_settings ss;
+
+    pt_camera_info cam_info, cam_desired;
+    f fov = 56;
+    bool active = false;
+
+    std::mt19937 rng;
+    cv::Mat1b gray, noise;
+    // normalized to the frame's size
+    std::vector<cv::Point2f> reflections;
+
+    std::vector<double> pose_times;
+    std::vector<pose> poses;
+
+    unsigned frame_idx = 0;
+    clock::time_point next_frame;
+    std::ofstream truth;
+};
+
+} // ns pt_module
@@ -0,0 +1,226 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "multi-camera.hpp"
+#include "compat/camera-names.hpp"
+#include "compat/math-imports.hpp"
+#include "compat/rt-thread.hpp"
+#include "compat/sleep.hpp"
+
+#include <QDebug>
+
+namespace pt_module {
+
+void undistort_points(const lens_distortion::undistorter& undistort, std::vector<vec2>& points, int w, int h)
+{
+    if (!undistort.is_enabled())
+        return;
+
+    // moved by the correction's difference in pixels, since to_pixel_pos()
+    // isn't exactly the inverse of the extractor's to_screen_pos()
+    for (vec2& p : points)
+    {
+        const auto [x, y] = pt_pixel_pos_mixin::to_pixel_pos(p[0], p[1], w, h);
+        const cv::Point2f u = undistort(cv::Point2f((float)x, (float)y));
+        p[0] += (u.x - (float)x) / w;
+        p[1] -= (u.y - (float)y) / w;
+    }
+}
+
+Affine camera_extrinsics(const pt_extra_camera_settings& s)
+{
+    constexpr f deg2rad = pi / 180;
+    const f yaw = f(*s.yaw) * deg2rad, pitch = f(*s.pitch) * deg2rad, roll = f(*s.roll) * deg2rad;
+    const f cy = std::cos(yaw), sy = std::sin(yaw);
+    const f cp = std::cos(pitch), sp = std::sin(pitch);
+    const f cr = std::cos(roll), sr = std::sin(roll);
+
+    const mat33 Ry(cy, 0, sy,
+                   0, 1, 0,
+                   -sy, 0, cy);
+    const mat33 Rx(1, 0, 0,
+                   0, cp, -sp,
+                   0, sp, cp);
+    const mat33 Rz(cr, -sr, 0,
+                   sr, cr, 0,
+                   0, 0, 1);
+
+    return { Ry * Rx * Rz, vec3(f(*s.x), f(*s.y), f(*s.z)) };
+}
+
+void set_camera_extrinsics(pt_extra_camera_settings& s, const Affine& X)
+{
+    constexpr double rad2deg = 180 / M_PI;
+    const mat33& R = X.R;
+
+    s.x = (double)X.t[0];
+    s.y = (double)X.t[1];
+    s.z = (double)X.t[2];
+    s.pitch = rad2deg * std::asin(clamp(-(double)R(1, 2), -1., 1.));
+    s.yaw = rad2deg * std::atan2((double)R(0, 2), (double)R(2, 2));
+    s.roll = rad2deg * std::atan2((double)R(1, 0), (double)R(1, 1));
+}
+
+Affine inverse(const Affine& X)
+{
+    const mat33 R = X.R.t();
+    return { R, -(R * X.t) };
+}
+
+bool fuse_poses(const pose_sample* samples, unsigned nsamples, Affine& X_C1M)
+{
+    // a single camera's depth is this many times less certain than the
+    // position across its view. about the ratio of the model's distance
+    // to its size at the usual distances.
+    constexpr f depth_ratio = 8;
+
+    mat33 R_sum = mat33::zeros(), info = mat33::zeros();
+    vec3 info_t(0, 0, 0);
+    unsigned nused = 0;
+
+    for (unsigned k = 0; k < nsamples; k++)
+    {
+        const pose_sample& x = samples[k];
+        const f w = x.confidence;
+
+        vec3 ray = x.X_C1M.t - x.camera_pos;
+        const f dist = (f)cv::norm(ray);
+
+        // the distances PointTracker can solve at. a pose outside them is
+        // wrong, and nearer than that it'd outweigh all the others.
+        if (!(w > 0) || !(dist > 100 && dist < 5000))
+            continue;
+
+        R_sum += w * x.X_C1M.R;
+        ray *= 1 / dist;
+
+        const mat33 along = ray * ray.t();
+        const mat33 I = w / (dist * dist) * (mat33::eye() - along + along * (1 / (depth_ratio * depth_ratio)));
+
+        info += I;
+        info_t += I * x.X_C1M.t;
+        nused++;
+    }
+
+    if (nused == 0)
+        return false;
+
+    X_C1M = { nearest_rotation(R_sum), info.inv(cv::DECOMP_CHOLESKY) * info_t };
+    return true;
+}
+
+mat33 nearest_rotation(const mat33& M)
+{
+    mat33 U, Vt;
+    cv::Matx<f, 3, 1> S;
+    cv::SVD::compute(M, S, U, Vt);
+
+    if (cv::determinant(U * Vt) < 0)
+        return U * mat33(1, 0, 0, 0, 1, 0, 0, 0, -1) * Vt;
+    return U * Vt;
+}
+
+extra_camera::extra_camera(const pt_runtime_traits& traits, unsigned idx, const Timer& clock) :
+    s { traits.get_module_name() },
+    cs { traits.get_module_name(), idx },
+    idx { idx },
+    clock { clock }
+{
+    if (cs.camera_name->isEmpty())
+        return;
+
+    camera = traits.make_extra_camera();
+
+    if (!camera)
+    {
+        qDebug() << "pt: no extra cameras with" << *s.camera_name;
+        return;
+    }
+
+    extractor = traits.make_point_extractor();
+    frame = traits.make_frame();
+    // headless, the extractor skips drawing
+    preview = traits.make_preview(0, 0);
+
+    camera->set_fov(cs.fov);
+
+    start(QThread::HighPriority);
+}
+
+extra_camera::~extra_camera()
+{
+    requestInterruption();
+    wait();
+
+    if (camera)
+        camera->stop();
+}
+
+extra_camera::result extra_camera::get_result() const
+{
+    QMutexLocker l(&mtx);
+    return last;
+}
+
+void extra_camera::reset_state()
+{
+    QMutexLocker l(&mtx);
+    point_tracker.reset_state();
+}
+
+void extra_camera::run()
+{
+    (void)rt_thread::apply(rt_thread::capture, "pt-extra");
+
+    const QString name = cs.camera_name;
+
+    if (!camera->start(camera_name_to_index(name), s.cam_fps, s.cam_res_x, s.cam_res_y))
+    {
+        qDebug() << "pt: can't open extra camera" << name;
+        return;
+    }
+
+    qDebug() << "pt: extra camera" << name;
+
+    while (!isInterruptionRequested())
+    {
+        const auto [new_frame, info] = camera->get_frame(*frame);
+
+        if (!new_frame)
+        {
+            portable::sleep(1);
+            continue;
+        }
+
+        result ret;
+        ret.capture_ns = clock.elapsed_nsecs() - info.capture_age_ns;
+
+        extractor->extract_points(*frame, *preview, points);
+
+        undistort.update(name, info.res_x, info.res_y, info.fov);
+        undistort_points(undistort, points, info.res_x, info.res_y);
+
+        ret.npoints = (unsigned)points.size();
+
+        QMutexLocker l(&mtx);
+
+        if (points.size() >= PointModel::N_POINTS)
+        {
+            ret.ok = point_tracker.track(points,
+                                         PointModel(s),
+                                         info,
+                                         s.dynamic_pose ? s.init_phase_timeout : 0,
+                                         *s.pose_solver);
+            ret.X_CkM = point_tracker.pose();
+            ret.confidence = point_tracker.confidence();
+        }
+
+        last = ret;
+    }
+}
+
+} // ns pt_module
@@ -0,0 +1,99 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+// Cameras besides the first one. Each captures, extracts and solves for
+// the pose on its own thread; the first camera's thread picks the results
+// captured closest to its own frame and fuses them in its frame of
+// reference, given where the other cameras are relative to it.
+
+#include "pt-api.hpp"
+#include "point_tracker.h"
+#include "cv/affine.hpp"
+#include "cv/lens-distortion.hpp"
+#include "compat/timer.hpp"
+
+#include <memory>
+#include <vector>
+
+#include <QMutex>
+#include <QThread>
+
+namespace pt_module {
+
+using namespace numeric_types;
+
+// moves points in screen coordinates by the lens model's correction
+void undistort_points(const lens_distortion::undistorter& undistort, std::vector<vec2>& points, int w, int h);
+
+// pose of another camera in the first camera's frame. angles are applied
+// as yaw about y, then pitch about x, then roll about z.
+Affine camera_extrinsics(const pt_extra_camera_settings& s);
+void set_camera_extrinsics(pt_extra_camera_settings& s, const Affine& X_C1Ck);
+
+Affine inverse(const Affine& X);
+
+struct pose_sample final
+{
+    Affine X_C1M;       // model in the first camera's frame
+    vec3 camera_pos;    // the camera that saw it, same frame
+    f confidence = 0;
+};
+
+// weighted by confidence, and for the translation by how little each
+// camera can tell about the model's distance along its line of sight.
+// false when none of the samples is usable.
+bool fuse_poses(const pose_sample* samples, unsigned nsamples, Affine& X_C1M);
+// the rotation closest to a sum of rotations
+mat33 nearest_rotation(const mat33& M);
+
+class extra_camera final : public QThread
+{
+public:
+    struct result final
+    {
+        Affine X_CkM;
+        Timer::time_type capture_ns = 0;
+        f confidence = 0;
+        unsigned npoints = 0;
+        bool ok = false;
+    };
+
+    // capture times are read off `clock', shared by all the cameras
+    extra_camera(const pt_runtime_traits& traits, unsigned idx, const Timer& clock);
+    ~extra_camera() override;
+
+    [[nodiscard]] bool is_enabled() const { return camera != nullptr; }
+    // of its pt_extra_camera_settings
+    unsigned index() const { return idx; }
+    result get_result() const;
+    Affine extrinsics() const { return camera_extrinsics(cs); }
+    void reset_state();
+
+private:
+    void run() override;
+
+    pt_settings s;
+    pt_extra_camera_settings cs;
+    unsigned idx;
+    const Timer& clock;
+
+    pt_pointer<pt_camera> camera;
+    pt_pointer<pt_point_extractor> extractor;
+    pt_pointer<pt_frame> frame;
+    pt_pointer<pt_preview> preview;
+
+    std::vector<vec2> points;
+    lens_distortion::undistorter undistort;
+
+    mutable QMutex mtx;
+    PointTracker point_tracker;
+    result last;
+};
+
+} // ns pt_module
@@ -7,7 +7,9 @@
 
 #include "point_tracker.h"
 #include "compat/math-imports.hpp"
+#include "compat/math.hpp"
 
+#include <array>
 #include <vector>
 #include <algorithm>
 #include <cmath>
@@ -135,29 +137,198 @@ PointTracker::PointOrder PointTracker::find_correspondences_previous(const vec2*
     return p;
 }
 
-void PointTracker::track(const std::vector<vec2>& points,
+bool PointTracker::track(const std::vector<vec2>& points,
                          const PointModel& model,
                          const pt_camera_info& info,
-                         int init_phase_timeout)
+                         int init_phase_timeout,
+                         pt_solver_type solver)
 {
     const f fx = pt_camera_info::get_focal_length(info.fov, info.res_x, info.res_y);
-    PointOrder order;
+    const bool tracking = !(init_phase_timeout <= 0 || t.elapsed_ms() > init_phase_timeout || init_phase);
+    int ret;
 
-    if (init_phase_timeout <= 0 || t.elapsed_ms() > init_phase_timeout || init_phase)
+    if (points.size() > PointModel::N_POINTS)
+        ret = track_robust(points.data(), std::min((unsigned)points.size(), max_candidates), model, fx, tracking, solver);
+    else
     {
-        init_phase = true;
-        order = find_correspondences(points.data(), model);
+        PointOrder order;
+
+        if (!tracking)
+        {
+            init_phase = true;
+            order = find_correspondences(points.data(), model);
+        }
+        else
+            order = find_correspondences_previous(points.data(), model, info);
+
+        ret = solve(model, order, fx, solver);
+        confidence_ = ret != -1 ? 1 : 0;
     }
-    else
-        order = find_correspondences_previous(points.data(), model, info);
 
-    if (POSIT(model, order, fx) != -1)
+    if (ret != -1)
     {
         init_phase = false;
         t.start();
     }
     else
         reset_state();
+
+    return ret != -1;
+}
+
+int PointTracker::solve(const PointModel& model, const PointOrder& order, f focal_length, pt_solver_type solver)
+{
+    return solver == pt_solver_p3p
+           ? P3P(model, order, focal_length)
+           : POSIT(model, order, focal_length);
+}
+
+bool PointTracker::is_plausible(const Affine& X_CM)
+{
+    // in front of the camera between 10 cm and 5 m, and turned less than
+    // 90 degrees away from it. the LEDs can't be seen past that anyway.
+    const f z = X_CM.t[2];
+    const f trace = X_CM.R(0, 0) + X_CM.R(1, 1) + X_CM.R(2, 2);
+
+    return z > 100 && z < 5000 && trace > 1;
+}
+
+int PointTracker::track_robust(const vec2* points, unsigned npoints, const PointModel& model, f fx,
+                               bool tracking, pt_solver_type solver)
+{
+    // reflections and sunlight show up as extra points, often brighter
+    // than the LEDs. with only three model points their projection fits
+    // any triangle, so the choice is made on where the model was expected,
+    // and failing that, on which triplet gives a pose that makes sense.
+
+    using triplet = std::array<unsigned, 3>;
+
+    if (tracking)
+    {
+        const vec2 expected[3] {
+            project(vec3(0, 0, 0), fx),
+            project(model.M01, fx),
+            project(model.M02, fx),
+        };
+
+        // the points move by a fraction of the model's size between frames
+        f size = 0;
+        for (unsigned i = 0; i < 3; i++)
+        {
+            const vec2 d = expected[i] - expected[(i+1)%3];
+            size = std::fmax(size, d.dot(d));
+        }
+        const f gate = std::sqrt(size) * f(.5), gate2 = gate * gate;
+
+        f best = -1, second = -1;
+        triplet best_idx {};
+
+        for (unsigned i = 0; i < npoints; i++)
+            for (unsigned j = 0; j < npoints; j++)
+                for (unsigned k = 0; k < npoints; k++)
+                {
+                    if (i == j || j == k || i == k)
+                        continue;
+
+                    const vec2 d0 = points[i] - expected[0],
+                               d1 = points[j] - expected[1],
+                               d2 = points[k] - expected[2];
+                    const f e0 = d0.dot(d0), e1 = d1.dot(d1), e2 = d2.dot(d2);
+
+                    if (e0 > gate2 || e1 > gate2 || e2 > gate2)
+                        continue;
+
+                    const f err = e0 + e1 + e2;
+
+                    if (best < 0 || err < best)
+                    {
+                        second = best;
+                        best = err;
+                        best_idx = { i, j, k };
+                    }
+                    else if (second < 0 || err < second)
+                        second = err;
+                }
+
+        if (best >= 0 && gate > 0)
+        {
+            const int ret = solve(model, { points[best_idx[0]], points[best_idx[1]], points[best_idx[2]] }, fx, solver);
+
+            if (ret != -1)
+            {
+                // lower when the fit is loose, or another assignment fits
+                // almost as well
+                const f rms = std::sqrt(best / 3);
+                f c = clamp(1 - rms / gate, f(0), f(1));
+                if (second >= 0)
+                    c *= clamp((std::sqrt(second / 3) - rms) / gate * 4, f(0), f(1));
+                confidence_ = c;
+                return ret;
+            }
+        }
+    }
+
+    // no usable previous pose. triplets of the brightest points are solved
+    // for, and the plausible pose closest to the expected one wins. that's
+    // the last known pose if there's one, else facing the camera.
+    triplet triplets[max_candidates * (max_candidates-1) * (max_candidates-2) / 6];
+    unsigned ntriplets = 0;
+
+    for (unsigned i = 0; i < npoints; i++)
+        for (unsigned j = i+1; j < npoints; j++)
+            for (unsigned k = j+1; k < npoints; k++)
+                triplets[ntriplets++] = { i, j, k };
+
+    std::stable_sort(triplets, triplets + ntriplets, [](const triplet& a, const triplet& b) {
+        return a[0] + a[1] + a[2] < b[0] + b[1] + b[2];
+    });
+
+    init_phase = true;
+
+    const Affine X_CM_old = X_CM, X_CM_expected_old = X_CM_expected;
+    const mat33& R_expected = X_CM_expected_old.R;
+
+    Affine best_pose;
+    f best = -1, second = -1;
+    int best_ret = -1;
+
+    for (unsigned n = 0; n < ntriplets && n < max_init_solves; n++)
+    {
+        const triplet& idx = triplets[n];
+        const vec2 tri[3] { points[idx[0]], points[idx[1]], points[idx[2]] };
+
+        const int ret = solve(model, find_correspondences(tri, model), fx, solver);
+
+        if (ret != -1 && is_plausible(X_CM))
+        {
+            const f deviation = (f)cv::norm(mat33::eye() - R_expected * X_CM.R.t());
+
+            if (best < 0 || deviation < best)
+            {
+                second = best;
+                best = deviation;
+                best_pose = X_CM;
+                best_ret = ret;
+            }
+            else if (second < 0 || deviation < second)
+                second = deviation;
+        }
+
+        X_CM = X_CM_old;
+        X_CM_expected = X_CM_expected_old;
+    }
+
+    if (best_ret != -1)
+    {
+        X_CM = best_pose;
+        X_CM_expected = best_pose;
+        // sure when nothing else was close, .5 rad is about 20 degrees
+        confidence_ = second < 0 ? f(1) : clamp((second - best) * 2, f(0), f(1));
+        return best_ret;
+    }
+
+    confidence_ = 0;
+    return -1;
 }
 
 PointTracker::PointOrder PointTracker::find_correspondences(const vec2* points, const PointModel& model)
@@ -342,6 +513,276 @@ int PointTracker::POSIT(const PointModel& model, const PointOrder& order, f foca
     return i;
 }
 
+// P3P in double, floats lose the quartic's roots at head-tracking distances
+using vec3d = cv::Vec3d;
+using mat33d = cv::Matx33d;
+
+// the largest real root of x^3 + a x^2 + b x + c
+static double cubic_max_root(double a, double b, double c)
+{
+    const double q = (a*a - 3*b) / 9;
+    const double r = (2*a*a*a - 9*a*b + 27*c) / 54;
+
+    if (r*r < q*q*q)
+    {
+        // three real roots, -2 sqrt(q) cos((theta + 2 pi k)/3) - a/3. with
+        // theta in [0, pi], k = 1 has the smallest cosine.
+        const double theta = acos(clamp(r / sqrt(q*q*q), -1., 1.));
+        return -2 * sqrt(q) * cos((theta + 2 * M_PI) / 3) - a / 3;
+    }
+
+    double A = -std::cbrt(fabs(r) + sqrt(r*r - q*q*q));
+    if (r < 0)
+        A = -A;
+    const double B = A == 0 ? 0 : q / A;
+
+    return A + B - a / 3;
+}
+
+// real roots of c[0] x^4 + c[1] x^3 + c[2] x^2 + c[3] x + c[4], Ferrari's method
+static unsigned quartic_roots(const double (&c)[5], double (&roots)[4])
+{
+    if (fabs(c[0]) < 1e-12)
+        return 0;
+
+    const double b = c[1] / c[0], cc = c[2] / c[0], d = c[3] / c[0], e = c[4] / c[0];
+
+    // depressed: y^4 + p y^2 + q y + r, x = y - b/4
+    const double b2 = b*b;
+    const double p = cc - 3*b2/8;
+    const double q = b2*b/8 - b*cc/2 + d;
+    const double r = -3*b2*b2/256 + b2*cc/16 - b*d/4 + e;
+
+    unsigned n = 0;
+
+    auto quadratic = [&](double B, double C) {
+        const double disc = B*B - 4*C;
+        if (disc < 0)
+            return;
+        const double s = sqrt(disc);
+        roots[n++] = (-B + s) / 2 - b/4;
+        roots[n++] = (-B - s) / 2 - b/4;
+    };
+
+    if (fabs(q) < 1e-12)
+    {
+        // biquadratic
+        const double disc = p*p - 4*r;
+        if (disc < 0)
+            return 0;
+        for (const double y2 : { (-p + sqrt(disc)) / 2, (-p - sqrt(disc)) / 2 })
+            if (y2 >= 0)
+            {
+                roots[n++] = sqrt(y2) - b/4;
+                roots[n++] = -sqrt(y2) - b/4;
+            }
+    }
+    else
+    {
+        // (y^2 + p/2 + m)^2 = (s y - q/(2s))^2 with s = sqrt(2m)
+        const double m = cubic_max_root(p, p*p/4 - r, -q*q/8);
+        if (m <= 0)
+            return 0;
+        const double s = sqrt(2*m);
+        quadratic(-s, p/2 + m + q/(2*s));
+        quadratic(s, p/2 + m - q/(2*s));
+    }
+
+    // polish against the original polynomial
+    for (unsigned k = 0; k < n; k++)
+    {
+        double& x = roots[k];
+        for (unsigned i = 0; i < 2; i++)
+        {
+            const double fx = (((c[0]*x + c[1])*x + c[2])*x + c[3])*x + c[4];
+            const double dfx = ((4*c[0]*x + 3*c[1])*x + 2*c[2])*x + c[3];
+            if (fabs(dfx) < 1e-15)
+                break;
+            x -= fx / dfx;
+        }
+    }
+
+    return n;
+}
+
+// orthonormal frame of a triangle, as columns
+static mat33d triangle_frame(const vec3d (&P)[3])
+{
+    const vec3d e1 = cv::normalize(P[1] - P[0]);
+    const vec3d e3 = cv::normalize(e1.cross(P[2] - P[0]));
+    const vec3d e2 = e3.cross(e1);
+
+    return {
+        e1[0], e2[0], e3[0],
+        e1[1], e2[1], e3[1],
+        e1[2], e2[2], e3[2],
+    };
+}
+
+static mat33d rodrigues(const vec3d& w)
+{
+    const mat33d K(0, -w[2], w[1],
+                   w[2], 0, -w[0],
+                   -w[1], w[0], 0);
+    const double theta = cv::norm(w);
+
+    if (theta < 1e-12)
+        return mat33d::eye() + K;
+
+    return mat33d::eye() + (sin(theta)/theta) * K + ((1 - cos(theta))/(theta*theta)) * (K * K);
+}
+
+int PointTracker::P3P(const PointModel& model, const PointOrder& order, f focal_length)
+{
+    // Grunert's solution as in
+    // [Robert M. Haralick et al.: "Review and Analysis of Solutions of the Three Point Perspective Pose Estimation Problem"]
+    // solving for the distances s_i along the rays to the model points
+    constexpr int gn_steps = 2;
+
+    const vec3d P[3] = {
+        { 0, 0, 0 },
+        { model.M01[0], model.M01[1], model.M01[2] },
+        { model.M02[0], model.M02[1], model.M02[2] },
+    };
+
+    vec3d rays[3];
+    for (unsigned i = 0; i < 3; i++)
+        rays[i] = cv::normalize(vec3d(order[i][0], order[i][1], focal_length));
+
+    // sides opposite each vertex and the angles between the rays
+    const vec3d P12 = P[1] - P[2], P02 = P[0] - P[2], P01 = P[0] - P[1];
+    const double a2 = P12.dot(P12), b2 = P02.dot(P02), c2 = P01.dot(P01);
+    const double cos_a = rays[1].dot(rays[2]), cos_b = rays[0].dot(rays[2]), cos_g = rays[0].dot(rays[1]);
+
+    if (b2 < 1e-6 || a2 < 1e-6 || c2 < 1e-6)
+        return -1;
+
+    const double amc = (a2 - c2) / b2, apc = (a2 + c2) / b2;
+    const double cos_a2 = cos_a*cos_a, cos_b2 = cos_b*cos_b, cos_g2 = cos_g*cos_g;
+
+    // v = s_2/s_0
+    const double coeffs[5] = {
+        (amc - 1)*(amc - 1) - 4*c2/b2*cos_a2,
+        4*(amc*(1 - amc)*cos_b - (1 - apc)*cos_a*cos_g + 2*c2/b2*cos_a2*cos_b),
+        2*(amc*amc - 1 + 2*amc*amc*cos_b2 + 2*(b2 - c2)/b2*cos_a2 - 4*apc*cos_a*cos_b*cos_g + 2*(b2 - a2)/b2*cos_g2),
+        4*(-amc*(1 + amc)*cos_b + 2*a2/b2*cos_g2*cos_b - (1 - apc)*cos_a*cos_g),
+        (1 + amc)*(1 + amc) - 4*a2/b2*cos_g2,
+    };
+
+    double roots[4];
+    const unsigned nroots = quartic_roots(coeffs, roots);
+
+    // pick the solution closer to the expected rotation, same as POSIT
+    const mat33d R_expected = X_CM_expected.R;
+    const mat33d model_frame_t = triangle_frame(P).t();
+
+    double best_deviation = INFINITY;
+    mat33d R;
+    vec3d t;
+
+    for (unsigned k = 0; k < nroots; k++)
+    {
+        const double v = roots[k];
+        const double denom = 2*(cos_g - v*cos_a);
+
+        if (v <= 0 || fabs(denom) < 1e-12)
+            continue;
+
+        // u = s_1/s_0
+        const double u = ((amc - 1)*v*v - 2*amc*cos_b*v + 1 + amc) / denom;
+        const double s0_sq = b2 / (1 + v*v - 2*v*cos_b);
+
+        if (u <= 0 || !(s0_sq > 0))
+            continue;
+
+        const double s0 = sqrt(s0_sq);
+        const vec3d C[3] = { s0 * rays[0], u*s0 * rays[1], v*s0 * rays[2] };
+
+        const mat33d R_k = triangle_frame(C) * model_frame_t;
+        const double deviation = cv::norm(mat33d::eye() - R_expected * R_k.t());
+
+        if (deviation < best_deviation)
+        {
+            best_deviation = deviation;
+            R = R_k;
+            t = C[0];
+        }
+    }
+
+    if (!std::isfinite(best_deviation))
+        return -1;
+
+    // three points pin down all six degrees of freedom, the steps only
+    // polish what the closed form lost to rounding
+    for (int step = 0; step < gn_steps; step++)
+    {
+        cv::Matx<double, 6, 6> J;
+        cv::Vec<double, 6> e;
+
+        for (unsigned i = 0; i < 3; i++)
+        {
+            const vec3d RP = R * P[i], C = RP + t;
+            const double z_inv = 1 / C[2], fz = focal_length * z_inv;
+
+            e[2*i+0] = fz * C[0] - (double)order[i][0];
+            e[2*i+1] = fz * C[1] - (double)order[i][1];
+
+            // d(projection)/dC
+            const double dx[3] = { fz, 0, -fz * C[0] * z_inv };
+            const double dy[3] = { 0, fz, -fz * C[1] * z_inv };
+
+            // dC/dw = -[RP]x for R <- exp([w]x) R, dC/dt = I
+            const mat33d dC_dw(0, RP[2], -RP[1],
+                               -RP[2], 0, RP[0],
+                               RP[1], -RP[0], 0);
+
+            for (unsigned j = 0; j < 3; j++)
+            {
+                J(2*i+0, j) = dx[0]*dC_dw(0, j) + dx[1]*dC_dw(1, j) + dx[2]*dC_dw(2, j);
+                J(2*i+1, j) = dy[0]*dC_dw(0, j) + dy[1]*dC_dw(1, j) + dy[2]*dC_dw(2, j);
+                J(2*i+0, j+3) = dx[j];
+                J(2*i+1, j+3) = dy[j];
+            }
+        }
+
+        // as many residuals as unknowns, J is square
+        const cv::Vec<double, 6> delta = J.solve(-e, cv::DECOMP_LU);
+
+        if (!std::isfinite(cv::norm(delta)))
+            break;
+
+        R = rodrigues(vec3d(delta[0], delta[1], delta[2])) * R;
+        t += vec3d(delta[3], delta[4], delta[5]);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            if (!std::isfinite(R(i, j)))
+            {
+                qDebug() << "p3p nan R";
+                return -1;
+            }
+
+        if (!std::isfinite(t[i]))
+        {
+            qDebug() << "p3p nan T";
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            X_CM.R(i, j) = (f)R(i, j);
+        X_CM.t[i] = (f)t[i];
+    }
+
+    X_CM_expected = X_CM;
+
+    return gn_steps;
+}
+
 #ifdef __clang__
 #   pragma clang diagnostic pop
 #endif
@@ -60,8 +60,13 @@ public:
     // track the pose using the set of normalized point coordinates (x pos in range -0.5:0.5)
     // f : (focal length)/(sensor width)
     // dt : time since last call
-    void track(const std::vector<vec2>& projected_points, const PointModel& model, const pt_camera_info& info, int init_phase_timeout);
+    // returns false when there's no pose, pose() is then the last one
+    bool track(const std::vector<vec2>& projected_points, const PointModel& model, const pt_camera_info& info,
+               int init_phase_timeout, pt_solver_type solver = pt_solver_posit);
     Affine pose() const { return X_CM; }
+    // how sure the last track() is of which points are the model's, 1
+    // with exactly three points, lower when others had to be ruled out
+    f confidence() const { return confidence_; }
     vec2 project(const vec3& v_M, f focal_length);
     vec2 project(const vec3& v_M, f focal_length, const Affine& X_CM);
     void reset_state();
@@ -72,14 +77,28 @@ private:
 
     PointOrder find_correspondences(const vec2* projected_points, const PointModel &model);
     PointOrder find_correspondences_previous(const vec2* points, const PointModel &model, const pt_camera_info& info);
+    // picks three of more than three points, returns as solve()
+    int track_robust(const vec2* points, unsigned npoints, const PointModel& model, f focal_length,
+                     bool tracking, pt_solver_type solver);
+    int solve(const PointModel& model, const PointOrder& order, f focal_length, pt_solver_type solver);
+    static bool is_plausible(const Affine& X_CM);
     // The POSIT algorithm, returns the number of iterations
     int POSIT(const PointModel& point_model, const PointOrder& order, f focal_length);
+    // Closed-form P3P followed by a fixed number of Gauss-Newton steps,
+    // returns the number of steps or -1 without a solution in front of the camera
+    int P3P(const PointModel& point_model, const PointOrder& order, f focal_length);
 
     Affine X_CM;  // transform from model to camera
     Affine X_CM_expected;
     PointOrder prev_positions;
     Timer t;
+    f confidence_ = 0;
     bool init_phase = true;
+
+    // brightest points considered when there's more than three
+    static constexpr unsigned max_candidates = 8;
+    // poses tried per frame when looking for the model without a previous pose
+    static constexpr unsigned max_init_solves = 16;
 };
 
 } // ns pt_module
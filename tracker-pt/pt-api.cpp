@@ -23,6 +23,12 @@ pt_camera::pt_camera() = default;
 pt_camera::~pt_camera() = default;
 pt_runtime_traits::pt_runtime_traits() = default;
 pt_runtime_traits::~pt_runtime_traits() = default;
+
+pt_runtime_traits::pointer<pt_camera> pt_runtime_traits::make_extra_camera() const
+{
+    return nullptr;
+}
+
 pt_point_extractor::pt_point_extractor() = default;
 pt_point_extractor::~pt_point_extractor() = default;
 
@@ -52,3 +58,8 @@ std::tuple<f, f> pt_pixel_pos_mixin::to_screen_pos(f px, f py, int w, int h)
 pt_frame::pt_frame() = default;
 
 pt_frame::~pt_frame() = default;
+
+bool pt_frame::to_gray(cv::Mat1b&) const
+{
+    return false;
+}
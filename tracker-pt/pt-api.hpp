@@ -5,6 +5,7 @@
 #include "cv/numeric.hpp"
 #include "options/options.hpp"
 
+#include <cstdint>
 #include <tuple>
 #include <type_traits>
 #include <memory>
@@ -31,6 +32,10 @@ struct pt_camera_info final
     int res_x = 0;
     int res_y = 0;
     int idx = -1;
+
+    // how long before get_frame() returned the frame was captured, for
+    // cameras that know. capture times are stamped less this.
+    std::int64_t capture_age_ns = 0;
 };
 
 struct pt_pixel_pos_mixin
@@ -46,6 +51,9 @@ struct pt_frame : pt_pixel_pos_mixin
     pt_frame();
     virtual ~pt_frame();
 
+    // for lens calibration, false if the frame isn't an image
+    virtual bool to_gray(cv::Mat1b& dst) const;
+
     template<typename t>
     t* as() &
     {
@@ -62,7 +70,8 @@ struct pt_frame : pt_pixel_pos_mixin
 struct pt_preview : pt_frame
 {
     virtual pt_preview& operator=(const pt_frame&) = 0;
-    virtual QImage get_bitmap() = 0;
+    // converts into a texture of the preview's size without allocating
+    virtual bool render_to(QImage& texture) = 0;
     virtual void draw_head_center(f x, f y) = 0;
 };
 
@@ -108,6 +117,8 @@ struct pt_runtime_traits
     virtual ~pt_runtime_traits();
 
     virtual pointer<pt_camera> make_camera() const = 0;
+    // a plain device for the second and later cameras, null if unsupported
+    virtual pointer<pt_camera> make_extra_camera() const;
     virtual pointer<pt_point_extractor> make_point_extractor() const = 0;
     virtual pointer<pt_frame> make_frame() const = 0;
     virtual pointer<pt_preview> make_preview(int w, int h) const = 0;
@@ -15,6 +15,40 @@ enum pt_color_type
     pt_color_green_only = 7,
 };
 
+enum pt_solver_type
+{
+    pt_solver_posit = 0,
+    pt_solver_p3p = 1,
+};
+
+// asks the camera for MJPEG and decodes only the luma plane, the values
+// being the downscale done by the decoder's IDCT
+enum pt_mjpeg_decode
+{
+    pt_mjpeg_off = 0,
+    pt_mjpeg_luma = 1,
+    pt_mjpeg_luma_half = 2,
+    pt_mjpeg_luma_quarter = 4,
+};
+
+// blobs are found on a max-pooled frame this many times smaller, then
+// measured at full resolution around each one
+enum pt_blob_search
+{
+    pt_blob_search_full = 1,
+    pt_blob_search_coarse_2 = 2,
+    pt_blob_search_coarse_4 = 4,
+};
+
+// camera-name selecting the synthetic camera of tracker-pt/module instead
+// of a device. takes effect when tracking starts.
+static inline const QString pt_synthetic_camera_name = QStringLiteral("(synthetic LEDs)");
+// receive points from opentrack-pt-blob-server over the network instead
+// of processing frames locally
+static inline const QString pt_remote_camera_name = QStringLiteral("(remote blobs)");
+// besides camera-name, see pt_extra_camera_settings
+static constexpr unsigned pt_max_extra_cameras = 2;
+
 namespace pt_settings_detail {
 
 using namespace options;
@@ -56,14 +90,41 @@ struct pt_settings final : options::opts
 
     value<bool> dynamic_pose { b, "dynamic-pose-resolution", false };
     value<int> init_phase_timeout { b, "init-phase-timeout", 250 };
+    value<pt_solver_type> pose_solver { b, "pose-solver", pt_solver_posit };
+    // point sizes are in pixels of the decoded frame
+    value<pt_mjpeg_decode> mjpeg_decode { b, "mjpeg-decode", pt_mjpeg_off };
+    value<pt_blob_search> blob_search { b, "blob-search", pt_blob_search_full };
     value<bool> auto_threshold { b, "automatic-threshold", true };
     value<pt_color_type> blob_color { b, "blob-color", pt_color_natural };
 
     value<slider_value> threshold_slider { b, "threshold-slider", { 128, 0, 255 } };
 
+    // raw frames are written to record_frames while tracking. a non-empty
+    // replay_frames is played back in a loop instead of opening the camera,
+    // at the recorded rate or as fast as frames are consumed.
+    value<QString> record_frames { b, "record-frames", "" },
+                   replay_frames { b, "replay-frames", "" };
+    value<bool> replay_realtime { b, "replay-realtime", true };
+
     explicit pt_settings(const QString& name) : opts(name) {}
 };
 
+// more cameras looking at the same model, numbered from 2. they share the
+// first camera's resolution and point extraction settings. their position
+// is in the first camera's frame, in millimeters and degrees.
+struct pt_extra_camera_settings final : options::opts
+{
+    // empty for none
+    value<QString> camera_name { b, "camera-name", "" };
+    value<int> fov { b, "camera-fov", 56 };
+    value<double> x { b, "x", 0 }, y { b, "y", 0 }, z { b, "z", 0 };
+    value<double> yaw { b, "yaw", 0 }, pitch { b, "pitch", 0 }, roll { b, "roll", 0 };
+
+    pt_extra_camera_settings(const QString& name, unsigned idx) :
+        opts(QStringLiteral("%1-camera-%2").arg(name).arg(idx + 2))
+    {}
+};
+
 #ifdef __clang__
 #   pragma clang diagnostic pop
 #endif
@@ -71,3 +132,4 @@ struct pt_settings final : options::opts
 } // ns pt_settings_detail
 
 using pt_settings = pt_settings_detail::pt_settings;
+using pt_extra_camera_settings = pt_settings_detail::pt_extra_camera_settings;
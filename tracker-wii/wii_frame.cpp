@@ -9,19 +9,21 @@
 #include "wii_frame.hpp"
 
 #include "compat/math.hpp"
+#include "cv/video-widget.hpp"
 
 #include <cstring>
 #include <tuple>
 
 #include <opencv2/imgproc.hpp>
 
+#include <QPainter>
+
 namespace pt_module {
 
 WIIPreview& WIIPreview::operator=(const pt_frame& frame_)
 {
     const struct wii_info& wii = frame_.as_const<WIIFrame>()->wii;
     const cv::Mat& frame = frame_.as_const<const WIIFrame>()->mat;
-    ensure_size(frame_copy, frame_out.cols, frame_out.rows, CV_8UC3);
 
     status = wii.status;
 
@@ -31,9 +33,9 @@ WIIPreview& WIIPreview::operator=(const pt_frame& frame_)
         return *this;
     }
 
-    const bool need_resize = frame.cols != frame_out.cols || frame.rows != frame_out.rows;
+    const bool need_resize = frame.cols != frame_copy.cols || frame.rows != frame_copy.rows;
     if (need_resize)
-        cv::resize(frame, frame_copy, cv::Size(frame_out.cols, frame_out.rows), 0, 0, cv::INTER_NEAREST);
+        cv::resize(frame, frame_copy, frame_copy.size(), 0, 0, cv::INTER_NEAREST);
     else
         frame.copyTo(frame_copy);
 
@@ -42,40 +44,47 @@ WIIPreview& WIIPreview::operator=(const pt_frame& frame_)
 
 WIIPreview::WIIPreview(int w, int h)
 {
-    ensure_size(frame_out, w, h, CV_8UC4);
+    ensure_size(frame_copy, w, h, CV_8UC3);
+
+    frame_copy.setTo(cv::Scalar(0, 0, 0));
+}
 
-    frame_out.setTo(cv::Scalar(0, 0, 0, 0));
+static const QImage& status_image(wii_camera_status status)
+{
+    static const QImage usb(":/Resources/usb.png"),
+                        sync(":/Resources/sync.png"),
+                        on(":/Resources/on.png");
+    switch (status)
+    {
+    case wii_cam_wait_for_dongle: return usb;
+    case wii_cam_wait_for_sync: return sync;
+    default: return on;
+    }
 }
 
-QImage WIIPreview::get_bitmap()
+bool WIIPreview::render_to(QImage& texture)
 {
     switch (status) {
     case wii_cam_wait_for_dongle:
-        return QImage(":/Resources/usb.png");
     case wii_cam_wait_for_sync:
-        return QImage(":/Resources/sync.png");
     case wii_cam_wait_for_connect:
-        return QImage(":/Resources/on.png");
+    {
+        QPainter painter(&texture);
+        painter.drawImage(texture.rect(), status_image(status));
+        return true;
+    }
     case wii_cam_data_change:
     case wii_cam_data_no_change:
         break;
     }
 
-    int stride = frame_out.step.p[0];
-
-    if (stride < 64 || stride < frame_out.cols * 4)
-    {
-        eval_once(qDebug() << "bad stride" << stride
-                           << "for bitmap size" << frame_copy.cols << frame_copy.rows);
-        return QImage();
-    }
+    if (texture.width() != frame_copy.cols || texture.height() != frame_copy.rows)
+        return false;
 
-    cv::cvtColor(frame_copy, frame_out, cv::COLOR_BGR2BGRA);
+    cv::Mat dest = cv_video_widget::as_mat(texture);
+    cv::cvtColor(frame_copy, dest, cv::COLOR_BGR2BGRA);
 
-    return QImage((const unsigned char*) frame_out.data,
-                  frame_out.cols, frame_out.rows,
-                  stride,
-                  QImage::Format_ARGB32);
+    return true;
 }
 
 void WIIPreview::draw_head_center(f x, f y)
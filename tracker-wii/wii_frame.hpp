@@ -51,7 +51,7 @@ struct WIIPreview final : pt_preview
     WIIPreview(int w, int h);
 
     WIIPreview& operator=(const pt_frame& frame) override;
-    QImage get_bitmap() override;
+    bool render_to(QImage& texture) override;
     void draw_head_center(f x, f y) override;
 
     operator cv::Mat&() { return frame_copy; }
@@ -60,7 +60,7 @@ struct WIIPreview final : pt_preview
 private:
     static void ensure_size(cv::Mat& frame, int w, int h, int type);
 
-    cv::Mat frame_copy, frame_out;
+    cv::Mat frame_copy;
     wii_camera_status status = wii_cam_wait_for_dongle;
 };
 
@@ -0,0 +1,319 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+// Replays tracklogger recordings through a filter with different settings
+// and writes the best ones found into the profile.
+//
+// Filter settings live in process-wide bundles, so candidates are scored
+// in worker processes (this executable with --worker), one per core, each
+// reading a candidate per line from stdin and answering on stdout.
+
+#include "tuner.hpp"
+#include "options/globals.hpp"
+#include "compat/library-path.hpp"
+#include "compat/sysexits.hpp"
+#include "compat/math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QProcess>
+#include <QTextStream>
+#include <QDebug>
+
+using namespace tune_filter;
+
+#ifdef __clang__
+#   pragma GCC diagnostic ignored "-Wmain"
+#endif
+
+static void qdebug_to_stderr(QtMsgType, const QMessageLogContext&, const QString& msg)
+{
+    std::fprintf(stderr, "%s\n", msg.toLocal8Bit().constData());
+    std::fflush(stderr);
+}
+
+struct candidate final
+{
+    std::vector<double> values;
+    result r;
+    double score = INFINITY;
+};
+
+static int run_worker(const std::shared_ptr<dylib>& lib, const filter_params& f, const std::vector<recording>& recs)
+{
+    QTextStream in(stdin), out(stdout);
+
+    for (QString line; in.readLineInto(&line); )
+    {
+        std::vector<double> values;
+        for (const QString& x : line.split(' ', QString::SkipEmptyParts))
+            values.push_back(x.toDouble());
+
+        if (values.size() != f.params.size())
+            return EX_PROTOCOL;
+
+        set_params(f, values);
+        const result r = evaluate(lib, recs);
+
+        out << QString::number(r.jitter, 'g', 17) << ' ' << QString::number(r.lag_ms, 'g', 17) << '\n';
+        out.flush();
+    }
+
+    return EX_OK;
+}
+
+// scores a batch on all workers, candidates are dealt out round-robin
+static bool score_batch(std::vector<std::unique_ptr<QProcess>>& workers, std::vector<candidate>& batch, double lag_weight_ms)
+{
+    const unsigned nworkers = (unsigned)workers.size();
+
+    for (unsigned k = 0; k < batch.size(); k++)
+    {
+        QByteArray line;
+        for (double x : batch[k].values)
+            line += QByteArray::number(x, 'g', 17) + ' ';
+        line += '\n';
+        workers[k % nworkers]->write(line);
+    }
+
+    for (unsigned k = 0; k < batch.size(); k++)
+    {
+        QProcess& w = *workers[k % nworkers];
+
+        while (!w.canReadLine())
+            if (!w.waitForReadyRead(-1))
+            {
+                qDebug() << "tune-filter: worker exited:" << w.errorString();
+                return false;
+            }
+
+        const QList<QByteArray> xs = w.readLine().trimmed().split(' ');
+        candidate& c = batch[k];
+
+        if (xs.size() != 2)
+            return false;
+
+        c.r = { xs[0].toDouble(), xs[1].toDouble() };
+        // an unfiltered input scores 1, so does lag_weight_ms of lag
+        c.score = c.r.jitter + std::fabs(c.r.lag_ms) / lag_weight_ms;
+        if (!std::isfinite(c.score))
+            c.score = INFINITY;
+    }
+
+    return true;
+}
+
+static QString describe(const filter_params& f, const candidate& c)
+{
+    QString ret = QStringLiteral("score %1 jitter %2 lag %3 ms\n")
+                  .arg(c.score, 0, 'f', 4).arg(c.r.jitter, 0, 'f', 4).arg(c.r.lag_ms, 0, 'f', 1);
+    for (unsigned k = 0; k < f.params.size(); k++)
+        ret += QStringLiteral("    %1 = %2\n").arg(f.params[k].key).arg(c.values[k], 0, 'g', 4);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    (void)qInstallMessageHandler(qdebug_to_stderr);
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Tune a filter's settings against tracklogger recordings.");
+    p.addHelpOption();
+
+    QCommandLineOption filter_opt("filter", "Filter module, one of accela, ewma, kalman, one-euro.", "name");
+    QCommandLineOption profile_opt("profile", "Profile .ini to read the current settings from and write the best ones to.", "path");
+    QCommandLineOption rounds_opt("rounds", "Search rounds.", "n", "6");
+    QCommandLineOption batch_opt("batch", "Candidates per round.", "n", "64");
+    QCommandLineOption threads_opt("threads", "Worker processes, 0 for one per core.", "n", "0");
+    QCommandLineOption lag_opt("lag-weight", "Milliseconds of lag that cost as much as unfiltered jitter.", "ms", "50");
+    QCommandLineOption seed_opt("seed", "Random seed.", "n", "1");
+    QCommandLineOption dry_run_opt("dry-run", "Don't write the profile.");
+    QCommandLineOption worker_opt("worker");
+    worker_opt.setFlags(QCommandLineOption::HiddenFromHelp);
+
+    p.addOptions({ filter_opt, profile_opt, rounds_opt, batch_opt, threads_opt, lag_opt, seed_opt, dry_run_opt, worker_opt });
+    p.addPositionalArgument("recordings", "Tracklogger .csv files.", "file...");
+    p.process(app);
+
+    const filter_params* f = params_for(p.value(filter_opt));
+
+    if (!f)
+    {
+        qDebug() << "tune-filter: unknown --filter" << p.value(filter_opt);
+        return EX_USAGE;
+    }
+
+    if (!p.isSet(profile_opt) || p.positionalArguments().isEmpty())
+        p.showHelp(EX_USAGE);
+
+    const QString profile = QFileInfo(p.value(profile_opt)).absoluteFilePath();
+
+    if (!QFileInfo(profile).isFile())
+    {
+        qDebug() << "tune-filter: no such profile" << profile;
+        return EX_NOINPUT;
+    }
+
+    options::globals::force_ini_pathname(profile);
+
+    if (p.isSet(worker_opt))
+    {
+        const QString filename = OPENTRACK_BASE_PATH + OPENTRACK_LIBRARY_PATH +
+                                 "/" OPENTRACK_LIBRARY_PREFIX "opentrack-filter-" + f->module +
+                                 "." OPENTRACK_LIBRARY_EXTENSION;
+        auto lib = std::make_shared<dylib>(filename, dylib::Filter);
+
+        std::vector<recording> recs(p.positionalArguments().size());
+        for (unsigned k = 0; k < recs.size(); k++)
+        {
+            QString error;
+            if (!recs[k].read(p.positionalArguments()[k], error))
+                return EX_DATAERR;
+        }
+
+        if (!lib->load())
+            return EX_UNAVAILABLE;
+
+        return run_worker(lib, *f, recs);
+    }
+
+    // check the recordings once here for a readable error
+    for (const QString& pathname : p.positionalArguments())
+    {
+        recording r; QString error;
+        if (!r.read(pathname, error))
+        {
+            qDebug() << "tune-filter:" << pathname << error;
+            return EX_DATAERR;
+        }
+    }
+
+    const unsigned rounds = std::max(1u, p.value(rounds_opt).toUInt());
+    const unsigned batch_size = std::max(2u, p.value(batch_opt).toUInt());
+    const double lag_weight_ms = std::fmax(1, p.value(lag_opt).toDouble());
+    unsigned nworkers = p.value(threads_opt).toUInt();
+
+    if (nworkers == 0)
+        nworkers = std::max(1u, std::thread::hardware_concurrency());
+    nworkers = std::min(nworkers, batch_size);
+
+    std::vector<std::unique_ptr<QProcess>> workers;
+
+    for (unsigned k = 0; k < nworkers; k++)
+    {
+        auto w = std::make_unique<QProcess>();
+        w->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        w->start(QCoreApplication::applicationFilePath(),
+                 QStringList{ "--worker", "--filter", f->module, "--profile", profile } + p.positionalArguments());
+        if (!w->waitForStarted())
+        {
+            qDebug() << "tune-filter: can't start worker:" << w->errorString();
+            return EX_OSERR;
+        }
+        workers.push_back(std::move(w));
+    }
+
+    const unsigned nparams = (unsigned)f->params.size();
+    std::mt19937 rng(p.value(seed_opt).toUInt());
+    std::uniform_real_distribution<double> uniform(0, 1);
+    std::normal_distribution<double> normal(0, 1);
+
+    // search in the unit cube, scaled to each setting's range
+    auto to_value = [f](unsigned k, double x) {
+        const param& q = f->params[k];
+        return q.min + clamp(x, 0., 1.) * (q.max - q.min);
+    };
+    auto to_unit = [f](unsigned k, double x) {
+        const param& q = f->params[k];
+        return q.max > q.min ? clamp((x - q.min) / (q.max - q.min), 0., 1.) : 0.;
+    };
+
+    // the baseline goes in the first batch so the result can't be worse
+    candidate baseline;
+    baseline.values = get_params(*f);
+
+    std::vector<candidate> best;
+
+    for (unsigned round = 0; round < rounds; round++)
+    {
+        std::vector<candidate> batch(batch_size);
+
+        // uniform at first, then gaussian around the best few with the
+        // radius halving each round
+        const double sigma = .25 * std::pow(.5, (int)round - 1);
+        const unsigned nparents = std::min((unsigned)best.size(), 4u);
+
+        for (unsigned j = 0; j < batch_size; j++)
+        {
+            candidate& c = batch[j];
+
+            if (round == 0 && j == 0)
+            {
+                c.values = baseline.values;
+                continue;
+            }
+
+            c.values.resize(nparams);
+
+            for (unsigned k = 0; k < nparams; k++)
+            {
+                double x;
+                if (round == 0)
+                    x = uniform(rng);
+                else
+                    x = to_unit(k, best[j % nparents].values[k]) + sigma * normal(rng);
+                c.values[k] = to_value(k, x);
+            }
+        }
+
+        if (!score_batch(workers, batch, lag_weight_ms))
+            return EX_SOFTWARE;
+
+        if (round == 0)
+            baseline = batch[0];
+
+        best.insert(best.end(), batch.begin(), batch.end());
+        std::sort(best.begin(), best.end(), [](const candidate& a, const candidate& b) { return a.score < b.score; });
+        best.resize(std::min((unsigned)best.size(), 4u));
+
+        qDebug().noquote() << QStringLiteral("round %1/%2: best score %3").arg(round + 1).arg(rounds).arg(best[0].score, 0, 'f', 4);
+    }
+
+    for (auto& w : workers)
+    {
+        w->closeWriteChannel();
+        (void)w->waitForFinished();
+    }
+
+    QTextStream out(stdout);
+    out << "current settings: " << describe(*f, baseline)
+        << "best settings: " << describe(*f, best[0]);
+    out.flush();
+
+    if (!std::isfinite(best[0].score))
+        return EX_DATAERR;
+
+    if (!p.isSet(dry_run_opt))
+    {
+        save_params(*f, best[0].values);
+        options::globals::flush_pending_saves();
+        qDebug() << "tune-filter: saved to" << profile;
+    }
+
+    return EX_OK;
+}
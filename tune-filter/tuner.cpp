@@ -0,0 +1,264 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#include "tuner.hpp"
+#include "api/plugin-api.hpp"
+#include "compat/timer.hpp"
+#include "compat/math.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+namespace tune_filter {
+
+// keep in sync with the filters' settings
+static const filter_params filters[] = {
+    { "accela", "accela-sliders", {
+        { "rotation-sensitivity", true, 1.5, .05, 2.5 },
+        { "translation-sensitivity", true, 1, .05, 1.5 },
+        { "rotation-deadzone", true, .03, 0, .2 },
+        { "translation-deadzone", true, .1, 0, 1 },
+    } },
+    { "ewma", "ewma-filter", {
+        { "min-smoothing", true, .02, .01, 1 },
+        { "max-smoothing", true, .7, .01, 1 },
+        { "smoothing-scale-curve", true, .8, .1, 5 },
+    } },
+    { "kalman", "kalman-filter", {
+        { "noise-rotation-slider", true, .5, 0, 1 },
+        { "noise-position-slider", true, .5, 0, 1 },
+    } },
+    { "one-euro", "one-euro-filter", {
+        { "rotation-min-cutoff", false, 1, .05, 5 },
+        { "rotation-beta", false, .02, 0, .2 },
+        { "rotation-derivative-cutoff", false, 1, .1, 5 },
+        { "position-min-cutoff", false, 1, .05, 5 },
+        { "position-beta", false, .05, 0, .5 },
+        { "position-derivative-cutoff", false, 1, .1, 5 },
+    } },
+};
+
+const filter_params* params_for(const QString& module_name)
+{
+    for (const filter_params& f : filters)
+        if (module_name == QLatin1String(f.module))
+            return &f;
+    return nullptr;
+}
+
+// axis speeds below are considered at rest, above four times that moving.
+// in between is neither, it'd only blur both measurements.
+static constexpr double rest_speed[6] = { 2, 2, 2, 5, 5, 5 }; // cm/s, deg/s
+static constexpr unsigned min_samples = 50;
+
+// the reference is the input through a forward-backward low-pass at this
+// cutoff, zero phase so it has no lag of its own
+static constexpr double ref_cutoff_hz = 5;
+
+bool recording::read(const QString& pathname, QString& error)
+{
+    QFile f(pathname);
+    if (!f.open(QFile::ReadOnly | QFile::Text))
+    {
+        error = f.errorString();
+        return false;
+    }
+
+    QTextStream s(&f);
+
+    const QStringList header = s.readLine().split(',');
+    static const char* const axes[6] = { "TX", "TY", "TZ", "Yaw", "Pitch", "Roll" };
+
+    const int dt_col = header.indexOf("dt");
+    int cols[6];
+
+    for (unsigned i = 0; i < 6; i++)
+        cols[i] = header.indexOf(QStringLiteral("corrected%1").arg(axes[i]));
+
+    if (dt_col == -1 || std::any_of(cols, cols + 6, [](int x) { return x == -1; }))
+    {
+        error = "not a tracklogger recording";
+        return false;
+    }
+
+    for (unsigned line = 2; !s.atEnd(); line++)
+    {
+        const QStringList row = s.readLine().split(',');
+        std::array<double, 6> pose;
+        bool ok = row.size() == header.size();
+        double t = 0;
+
+        if (ok)
+            t = row[dt_col].toDouble(&ok);
+        for (unsigned i = 0; ok && i < 6; i++)
+            pose[i] = row[cols[i]].toDouble(&ok);
+
+        if (!ok || !std::isfinite(t) || std::any_of(pose.cbegin(), pose.cend(), [](double x) { return !std::isfinite(x); }))
+        {
+            qDebug() << "tune-filter:" << pathname << "skipping line" << line;
+            continue;
+        }
+
+        dt.push_back(clamp(t, 1e-4, .1));
+        input.push_back(pose);
+    }
+
+    const unsigned n = (unsigned)input.size();
+
+    if (n < min_samples)
+    {
+        error = "recording too short";
+        return false;
+    }
+
+    ref = input;
+    speed.assign(n, {});
+
+    constexpr double RC = 1 / (2 * M_PI * ref_cutoff_hz);
+
+    for (unsigned k = 1; k < n; k++)
+    {
+        const double alpha = dt[k] / (dt[k] + RC);
+        for (unsigned i = 0; i < 6; i++)
+            ref[k][i] += (1 - alpha) * (ref[k-1][i] - ref[k][i]);
+    }
+
+    for (unsigned k = n - 1; k-- > 0; )
+    {
+        const double alpha = dt[k+1] / (dt[k+1] + RC);
+        for (unsigned i = 0; i < 6; i++)
+            ref[k][i] += (1 - alpha) * (ref[k+1][i] - ref[k][i]);
+    }
+
+    for (unsigned k = 1; k < n; k++)
+        for (unsigned i = 0; i < 6; i++)
+            speed[k][i] = (ref[k][i] - ref[k-1][i]) / dt[k];
+
+    return true;
+}
+
+void set_params(const filter_params& f, const std::vector<double>& values)
+{
+    bundle b = make_bundle(f.bundle);
+
+    for (unsigned k = 0; k < f.params.size(); k++)
+    {
+        const param& p = f.params[k];
+        const double x = clamp(values[k], p.min, p.max);
+
+        if (p.slider)
+        {
+            value<slider_value> v(b, p.key, { p.def, p.min, p.max });
+            v = slider_value(x, p.min, p.max);
+        }
+        else
+        {
+            value<double> v(b, p.key, p.def);
+            v = x;
+        }
+    }
+}
+
+std::vector<double> get_params(const filter_params& f)
+{
+    bundle b = make_bundle(f.bundle);
+    std::vector<double> ret;
+    ret.reserve(f.params.size());
+
+    for (const param& p : f.params)
+    {
+        if (p.slider)
+        {
+            const slider_value x = *value<slider_value>(b, p.key, { p.def, p.min, p.max });
+            ret.push_back(x.cur());
+        }
+        else
+            ret.push_back(*value<double>(b, p.key, p.def));
+    }
+
+    return ret;
+}
+
+void save_params(const filter_params& f, const std::vector<double>& values)
+{
+    set_params(f, values);
+    make_bundle(f.bundle)->save();
+}
+
+result evaluate(const std::shared_ptr<dylib>& lib, const std::vector<recording>& recs)
+{
+    struct axis_
+    {
+        double out_sq = 0, in_sq = 0;
+        double lag_num = 0, lag_den = 0;
+        unsigned rest = 0, moving = 0;
+    } axes[6];
+
+    for (const recording& r : recs)
+    {
+        // filters measure their own dt, feed them the recorded one
+        replay_clock clock;
+
+        std::shared_ptr<IFilter> f = make_dylib_instance<IFilter>(lib);
+        if (!f || !f->initialize().is_ok())
+            return { NAN, NAN };
+
+        double out[6], last_out[6];
+
+        for (unsigned k = 0; k < r.input.size(); k++)
+        {
+            clock.advance_nsecs(Timer::time_type(r.dt[k] * 1e9));
+            f->filter(r.input[k].data(), out);
+
+            for (unsigned i = 0; k > 0 && i < 6; i++)
+            {
+                axis_& a = axes[i];
+                const double v = r.speed[k][i], av = std::fabs(v);
+
+                if (av < rest_speed[i])
+                {
+                    const double d = out[i] - last_out[i], d_in = r.input[k][i] - r.input[k-1][i];
+                    a.out_sq += d*d; a.in_sq += d_in*d_in;
+                    a.rest++;
+                }
+                else if (av > 4 * rest_speed[i])
+                {
+                    // least squares for tau in out = ref - tau * speed
+                    a.lag_num += (r.ref[k][i] - out[i]) * v;
+                    a.lag_den += v*v;
+                    a.moving++;
+                }
+            }
+
+            std::copy(out, out + 6, last_out);
+        }
+    }
+
+    result ret;
+    unsigned njitter = 0, nlag = 0;
+
+    for (const axis_& a : axes)
+    {
+        if (a.rest >= min_samples && a.in_sq > 0)
+            ret.jitter += std::sqrt(a.out_sq / a.in_sq), njitter++;
+        if (a.moving >= min_samples && a.lag_den > 0)
+            ret.lag_ms += 1000 * a.lag_num / a.lag_den, nlag++;
+    }
+
+    if (njitter)
+        ret.jitter /= njitter;
+    if (nlag)
+        ret.lag_ms /= nlag;
+
+    return ret;
+}
+
+} // ns tune_filter
@@ -0,0 +1,68 @@
+/* Copyright (c) 2019 Stanislaw Halik <sthalik@misaki.pl>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ */
+
+#pragma once
+
+#include "api/plugin-support.hpp"
+#include "options/options.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <QString>
+
+namespace tune_filter {
+
+using namespace options;
+
+// a setting worth searching over. sliders keep their own bounds.
+struct param final
+{
+    const char* key;
+    bool slider;
+    double def, min, max;
+};
+
+struct filter_params final
+{
+    const char* module;
+    const char* bundle;
+    std::vector<param> params;
+};
+
+const filter_params* params_for(const QString& module_name);
+
+// the "corrected" columns of a tracklogger .csv, i.e. what the filter saw
+struct recording final
+{
+    std::vector<double> dt;
+    std::vector<std::array<double, 6>> input;
+
+    // zero-phase smoothed input and its speed, what the filter should
+    // ideally output
+    std::vector<std::array<double, 6>> ref, speed;
+
+    bool read(const QString& pathname, QString& error);
+};
+
+struct result final
+{
+    // output jitter at rest relative to the input's, 0 to ~1
+    double jitter = 0;
+    // how far the output trails the reference while moving
+    double lag_ms = 0;
+};
+
+// set in memory only, the profile isn't written to
+void set_params(const filter_params& f, const std::vector<double>& values);
+std::vector<double> get_params(const filter_params& f);
+void save_params(const filter_params& f, const std::vector<double>& values);
+
+result evaluate(const std::shared_ptr<dylib>& lib, const std::vector<recording>& recs);
+
+} // ns tune_filter
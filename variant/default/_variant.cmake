@@ -15,6 +15,7 @@ function(otr_init_variant)
         "gui"
         "main"
         "x-plane-plugin"
+        "poseshmclient"
         "csv"
         "pose-widget"
         "spline"
@@ -24,6 +25,8 @@ function(otr_init_variant)
         "migration"
         "main-window"
         "video"
+        "headless"
+        "tune-filter"
     )
 
     set_property(GLOBAL PROPERTY opentrack-subprojects "${subprojects}")
@@ -330,6 +330,7 @@ void main_window::create_copied_profile()
     if (!cur.isEmpty() && profile_name_from_dialog(name))
     {
         const QString new_name = ini_combine(name);
+        flush_pending_saves();
         (void) QFile::remove(new_name);
         QFile::copy(cur, new_name);
 
@@ -407,7 +408,8 @@ void main_window::start_tracker_()
     if (work)
         return;
 
-    work = std::make_shared<Work>(pose, ev, ui.video_frame, current_tracker(), current_protocol(), current_filter());
+    work = std::make_shared<Work>(pose, ev, ui.video_frame, current_tracker(), current_protocol(), current_filter(),
+                                  current_extra_protocols());
 
     if (!work->is_ok())
     {
@@ -576,7 +578,7 @@ static bool mk_dialog(std::unique_ptr<t>& place, const std::shared_ptr<dylib>& l
     using u = std::unique_ptr<t>;
 
     return mk_window_common(place, [&] {
-        if (lib && lib->Dialog)
+        if (lib && lib->load())
             return u{ (t*)lib->Dialog() };
         else
             return u{};
@@ -643,6 +645,10 @@ void main_window::exit(int status)
         tray->hide();
     tray = nullptr;
 
+    // the writer thread doesn't outlive QApplication everywhere, static
+    // destruction is too late for it
+    options::globals::flush_pending_saves();
+
     //close();
     QApplication::setQuitOnLastWindowClosed(true);
     QApplication::exit(status);
@@ -5,52 +5,124 @@
 
 #include <cstddef>
 #include <cstring>
+#include <utility>
 
 #include <QPainter>
 
-void video_widget::init_image_nolock()
+using namespace time_units;
+
+namespace video_impl {
+
+preview_settings::preview_settings() : opts("video-preview") {}
+
+} // ns video_impl
+
+bool video_widget::ensure_textures_nolock()
 {
-    texture = QImage(W, H, QImage::Format_ARGB32);
-    texture.setDevicePixelRatio(devicePixelRatioF());
+    if (W < 1 || H < 1)
+        return false;
+
+    if (back->width() == W && back->height() == H)
+        return true;
+
+    // only happens on resize, steady state never allocates
+    const double dpr = devicePixelRatioF();
+    for (QImage& tex : textures)
+    {
+        tex = QImage(W, H, QImage::Format_ARGB32);
+        tex.setDevicePixelRatio(dpr);
+        tex.fill(Qt::gray);
+    }
+    freshp = false;
+
+    return true;
 }
 
 video_widget::video_widget(QWidget* parent) : QWidget(parent)
 {
     W = width(); H = height();
-    init_image_nolock(); texture.fill(Qt::gray);
+
+    const int fps = clamp(*s.max_fps, 1, 1000);
+    frame_interval = ms{1000.f / fps};
+    cpu_budget = ms{(float)clamp(*s.cpu_budget_ms, 1, 1000)};
 
     connect(&timer, &QTimer::timeout, this, &video_widget::update_and_repaint, Qt::DirectConnection);
     timer.start(65);
 }
 
-void video_widget::update_image(const QImage& img)
+QImage* video_widget::begin_update()
 {
     QMutexLocker l(&mtx);
 
-    if (freshp)
+    if (frame_timer.elapsed<ms>() < frame_interval)
+        return nullptr;
+
+    if (budget_timer.elapsed<secs>() >= secs{1})
+    {
+        budget_timer.start();
+        budget_spent = {};
+    }
+
+    if (budget_spent >= cpu_budget)
+        return nullptr;
+
+    if (!ensure_textures_nolock())
+        return nullptr;
+
+    frame_timer.start();
+
+    // back buffer is owned by the caller until end_update()
+    return back;
+}
+
+void video_widget::end_update(ms cost)
+{
+    QMutexLocker l(&mtx);
+
+    budget_spent += cost;
+
+    // a resize may have reallocated the buffers in the meantime
+    if (back->width() != W || back->height() != H)
         return;
+
+    std::swap(back, pending);
     freshp = true;
+}
 
-    unsigned nbytes = (unsigned)(img.bytesPerLine() * img.height());
-    vec.resize(nbytes); vec.shrink_to_fit();
-    std::memcpy(vec.data(), img.constBits(), nbytes);
+void video_widget::update_image(const QImage& img)
+{
+    Timer t;
+
+    QImage* tex = begin_update();
+
+    if (!tex)
+        return;
 
-    texture = QImage((const unsigned char*) vec.data(), img.width(), img.height(), img.bytesPerLine(), img.format());
-    texture.setDevicePixelRatio(devicePixelRatioF());
+    if (img.size() == tex->size() && img.format() == tex->format() &&
+        img.bytesPerLine() == tex->bytesPerLine())
+    {
+        const unsigned nbytes = (unsigned)(img.bytesPerLine() * img.height());
+        std::memcpy(tex->bits(), img.constBits(), nbytes);
+    }
+    else
+    {
+        QPainter painter(tex);
+        painter.drawImage(tex->rect(), img);
+    }
+
+    end_update(t.elapsed<ms>());
 }
 
 void video_widget::paintEvent(QPaintEvent*)
 {
     QMutexLocker foo(&mtx);
 
-    if (texture.width() != W || texture.height() != H)
-    {
-        init_image_nolock();
-        texture.fill(Qt::gray);
-    }
-
     QPainter painter(this);
-    painter.drawImage(rect(), texture);
+
+    if (front->isNull())
+        painter.fillRect(rect(), Qt::gray);
+    else
+        painter.drawImage(rect(), *front);
 }
 
 void video_widget::update_and_repaint()
@@ -63,6 +135,7 @@ void video_widget::update_and_repaint()
     if (freshp)
     {
         freshp = false;
+        std::swap(front, pending);
         repaint();
     }
 }
@@ -73,7 +146,6 @@ void video_widget::resizeEvent(QResizeEvent*)
     double dpr = devicePixelRatioF();
     W = iround(width() * dpr);
     H = iround(height() * dpr);
-    init_image_nolock();
 }
 
 void video_widget::get_preview_size(int& w, int& h)
@@ -81,4 +153,3 @@ void video_widget::get_preview_size(int& w, int& h)
     QMutexLocker l(&mtx);
     w = W; h = H;
 }
-
@@ -8,14 +8,33 @@
 #pragma once
 
 #include "compat/math.hpp"
+#include "compat/timer.hpp"
+#include "options/options.hpp"
 #include "export.hpp"
 
-#include <vector>
+#include <array>
 
 #include <QWidget>
+#include <QImage>
 #include <QTimer>
 #include <QMutex>
 
+namespace video_impl {
+
+using namespace options;
+
+struct OTR_VIDEO_EXPORT preview_settings final : opts
+{
+    // frames per second handed to the widget, and milliseconds of tracker
+    // thread time per second the preview may spend scaling/converting
+    value<int> max_fps { b, "max-fps", 30 };
+    value<int> cpu_budget_ms { b, "cpu-budget-ms", 50 };
+
+    preview_settings();
+};
+
+} // ns video_impl
+
 class OTR_VIDEO_EXPORT video_widget : public QWidget
 {
     Q_OBJECT
@@ -26,21 +45,40 @@ public:
     void update_image(const QImage& image);
     void get_preview_size(int& w, int& h);
     void resizeEvent(QResizeEvent*) override;
+
+    // tracker thread: returns the back buffer, already allocated at the
+    // widget's resolution as Format_ARGB32, or nullptr if this frame
+    // should be dropped to stay within the preview's rate and CPU budget.
+    QImage* begin_update();
+    // tracker thread: publishes the buffer from begin_update(). `cost' is
+    // the time spent rendering the frame, charged against the CPU budget.
+    void end_update(time_units::ms cost);
+
 protected slots:
     void paintEvent(QPaintEvent*) override;
     void update_and_repaint();
 private:
     QTimer timer;
 
+    // front is painted, pending is the latest finished frame waiting to be
+    // swapped in, back is being rendered by the tracker thread.
+    std::array<QImage, 3> textures;
+    QImage* front = &textures[0];
+    QImage* pending = &textures[1];
+    QImage* back = &textures[2];
+
+    video_impl::preview_settings s;
+    Timer frame_timer, budget_timer;
+    time_units::ms budget_spent {};
+    time_units::ms frame_interval {}, cpu_budget {};
+
+    bool ensure_textures_nolock();
+
 protected:
     QMutex mtx { QMutex::Recursive };
-    QImage texture;
-    std::vector<unsigned char> vec;
 
     bool freshp = false;
 
     int W = iround(QWidget::width() * devicePixelRatioF());
     int H = iround(QWidget::height() * devicePixelRatioF());
-
-    void init_image_nolock();
 };
@@ -9,9 +9,13 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <fcntl.h>
 #include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <limits.h>
 #include <unistd.h>
 #include <math.h>
@@ -30,6 +34,7 @@
 /* using Wine name to ease things */
 #define WINE_SHM_NAME "facetracknoir-wine-shm"
 #define WINE_MTX_NAME "facetracknoir-wine-mtx"
+#define WINE_RING_NAME "facetracknoir-wine-ring"
 
 #include "compat/linkage-macros.hpp"
 
@@ -47,6 +52,24 @@ typedef struct shm_wrapper
     int fd, size;
 } shm_wrapper;
 
+/* same as proto-wine/wine-shm.h */
+#define WINE_SHM_SAMPLES 4
+
+typedef struct WineSHM_sample
+{
+    _Alignas(8) uint64_t seq;
+    uint64_t time_ns;
+    double data[6];
+} WineSHM_sample;
+
+typedef struct WineSHM_ring
+{
+    _Alignas(8) uint64_t head;
+    WineSHM_sample samples[WINE_SHM_SAMPLES];
+} volatile WineSHM_ring;
+
+_Static_assert(sizeof(WineSHM_ring) == 264, "WineSHM_ring layout changed");
+
 typedef struct WineSHM
 {
     double data[6];
@@ -57,6 +80,8 @@ typedef struct WineSHM
 
 static shm_wrapper* lck_posix = NULL;
 static WineSHM* shm_posix = NULL;
+static WineSHM_ring* ring_posix = NULL;
+static uint64_t ring_retry_time;
 static void *view_x, *view_y, *view_z, *view_heading, *view_pitch, *view_roll;
 static float offset_x, offset_y, offset_z;
 static XPLMCommandRef track_toggle = NULL, translation_disable_toggle = NULL;
@@ -103,23 +128,137 @@ void shm_wrapper_unlock(shm_wrapper* self)
     flock(self->fd, LOCK_UN);
 }
 
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* opentrack creates the ring, it's not there with an older one or before
+ * it started. looked for once a second until then, and only mapped if
+ * it's as large as expected. */
+static void open_ring(uint64_t now)
+{
+    if (ring_posix != NULL || now < ring_retry_time)
+        return;
+
+    ring_retry_time = now + 1000000000u;
+
+    const int fd = shm_open("/" WINE_RING_NAME, O_RDWR, 0600);
+    if (fd == -1)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(WineSHM_ring))
+    {
+        void* mem = mmap(NULL, sizeof(WineSHM_ring), PROT_READ|PROT_WRITE, MAP_SHARED, fd, (off_t)0);
+        if (mem != MAP_FAILED)
+            ring_posix = mem;
+    }
+
+    (void) close(fd);
+}
+
+/* false if opentrack was writing the slot meanwhile */
+static bool read_sample(uint64_t seq, WineSHM_sample* ret)
+{
+    const volatile WineSHM_sample* s = &ring_posix->samples[seq % WINE_SHM_SAMPLES];
+
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != seq)
+        return false;
+
+    ret->seq = seq;
+    ret->time_ns = __atomic_load_n(&s->time_ns, __ATOMIC_RELAXED);
+    for (int i = 0; i < 6; i++)
+        __atomic_load(&s->data[i], &ret->data[i], __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq;
+}
+
+/* the pose at the time of this frame, extrapolated from the last two
+ * samples. the sim's frames don't line up with opentrack's, taking the
+ * newest sample as-is makes the view step unevenly. */
+static bool get_pose(double* data)
+{
+    const uint64_t now = monotonic_ns();
+
+    open_ring(now);
+
+    if (ring_posix == NULL)
+        return false;
+
+    WineSHM_sample a, b;
+    const uint64_t head = __atomic_load_n(&ring_posix->head, __ATOMIC_ACQUIRE);
+
+    if (head == 0 || !read_sample(head, &b))
+        return false;
+
+    memcpy(data, b.data, sizeof(b.data));
+
+    if (head == 1 || !read_sample(head - 1, &a) || b.time_ns <= a.time_ns)
+        return true;
+
+    if (now <= b.time_ns)
+        return true;
+
+    /* by up to a sample's interval, then faded back out. opentrack
+     * not sending poses at all is more likely than it being late. */
+    const double interval = (double)(b.time_ns - a.time_ns);
+    const double dt = (double)(now - b.time_ns);
+
+    /* nothing new in a while. the locked read has the same pose, or a
+     * newer one from an opentrack that doesn't write the ring. */
+    if (dt >= 2 * interval)
+        return false;
+
+    const double ahead = dt <= interval ? dt : 2 * interval - dt;
+    const double t = ahead / interval;
+
+    for (int i = TX; i <= TZ; i++)
+        data[i] += (b.data[i] - a.data[i]) * t;
+    for (int i = Yaw; i <= Roll; i++)
+    {
+        /* the short way around */
+        double d = b.data[i] - a.data[i];
+        if (d > M_PI)
+            d -= 2 * M_PI;
+        else if (d < -M_PI)
+            d += 2 * M_PI;
+        data[i] += d * t;
+    }
+
+    return true;
+}
+
 float write_head_position(float inElapsedSinceLastCall,
                           float inElapsedTimeSinceLastFlightLoop,
                           int   inCounter,
                           void* inRefcon)
 {
     if (lck_posix != NULL && shm_posix != NULL) {
-        shm_wrapper_lock(lck_posix);
+        double data[6];
+
+        if (!get_pose(data))
+        {
+            /* no ring, or nothing recent in it */
+            shm_wrapper_lock(lck_posix);
+            for (int i = 0; i < 6; i++)
+                data[i] = shm_posix->data[i];
+            shm_wrapper_unlock(lck_posix);
+        }
+
         if (!translation_disabled)
         {
-            XPLMSetDataf(view_x, shm_posix->data[TX] * 1e-3 + offset_x);
-            XPLMSetDataf(view_y, shm_posix->data[TY] * 1e-3 + offset_y);
-            XPLMSetDataf(view_z, shm_posix->data[TZ] * 1e-3 + offset_z);
+            XPLMSetDataf(view_x, data[TX] * 1e-3 + offset_x);
+            XPLMSetDataf(view_y, data[TY] * 1e-3 + offset_y);
+            XPLMSetDataf(view_z, data[TZ] * 1e-3 + offset_z);
         }
-        XPLMSetDataf(view_heading, shm_posix->data[Yaw] * 180 / M_PI);
-        XPLMSetDataf(view_pitch, shm_posix->data[Pitch] * 180 / M_PI);
-        XPLMSetDataf(view_roll, shm_posix->data[Roll] * 180 / M_PI);
-        shm_wrapper_unlock(lck_posix);
+        XPLMSetDataf(view_heading, data[Yaw] * 180 / M_PI);
+        XPLMSetDataf(view_pitch, data[Pitch] * 180 / M_PI);
+        XPLMSetDataf(view_roll, data[Roll] * 180 / M_PI);
     }
     return -1.0;
 }
@@ -216,6 +355,12 @@ void XPluginStop (void) {
         lck_posix = NULL;
         shm_posix = NULL;
     }
+    if (ring_posix)
+    {
+        (void) munmap((void*)ring_posix, sizeof(WineSHM_ring));
+        ring_posix = NULL;
+        ring_retry_time = 0;
+    }
 }
 
 PLUGIN_API OTR_GENERIC_EXPORT